@@ -0,0 +1,189 @@
+/**
+    @file alloc.c
+    @author Samuel E McConnell (semcconn)
+    The alloc component hands out dynamically allocated memory for the rest of the program.
+    Every block starts with a small header that remembers its size and subsystem, so the
+    current and peak bytes of each subsystem can be counted without the callers passing
+    sizes back in when they free. Running out of memory is checked here once, so callers
+    never get a NULL pointer back.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "alloc.h"
+
+/**
+ * This is the header stored in front of every block. The union keeps the memory after
+ * the header aligned for any type.
+ * @param size as the number of bytes the caller asked for
+ * @param subsystem as the subsystem the block is counted against
+ */
+typedef union BlockHeader
+{
+    struct
+    {
+        size_t size;
+        Subsystem subsystem;
+    } info;
+    long double alignDouble;
+    void *alignPointer;
+    long long alignLong;
+} BlockHeader;
+
+/** The names of the subsystems, in the order of the Subsystem enum */
+static char const *const SUBSYSTEM_NAMES[MEM_SUBSYSTEMS] = {"catalog", "names", "trip", "query",
+                                                            "io", "output", "cache"};
+
+/** The functions memory is really allocated with */
+static Allocator allocator = {malloc, realloc, free};
+
+/** The counters for each subsystem */
+static MemoryStats stats[MEM_SUBSYSTEMS];
+
+/** The counters for the whole program */
+static MemoryStats total;
+
+/**
+    This function adds a newly allocated block to the counters.
+    @param counters as the counters being updated
+    @param size as the size of the block
+ */
+static void countAllocation(MemoryStats *counters, size_t size)
+{
+    counters->current += size;
+    counters->allocations++;
+    if (counters->current > counters->peak)
+    {
+        counters->peak = counters->current;
+    }
+}
+
+/**
+    This function removes a freed block from the counters.
+    @param counters as the counters being updated
+    @param size as the size of the block
+ */
+static void countFree(MemoryStats *counters, size_t size)
+{
+    counters->current -= size;
+    counters->frees++;
+}
+
+/**
+    This function exits the program because memory could not be allocated.
+    @param size as the number of bytes that were asked for
+ */
+static void outOfMemory(size_t size)
+{
+    fprintf(stderr, "Error: out of memory allocating %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+}
+
+/**
+    This function changes the functions memory is allocated with. It must be called before
+    anything is allocated.
+    @param newAllocator as the functions to use
+ */
+void setAllocator(Allocator const *newAllocator)
+{
+    allocator = *newAllocator;
+}
+
+/**
+    This function allocates a block of memory and counts it against a subsystem. The
+    program exits with an error message if there is no memory left.
+    @param subsystem as the subsystem the block is for
+    @param size as the number of bytes needed
+    @return a pointer to the block.
+ */
+void *allocate(Subsystem subsystem, size_t size)
+{
+    BlockHeader *header = (BlockHeader *)allocator.allocate(sizeof(BlockHeader) + size);
+    if (header == NULL)
+    {
+        outOfMemory(size);
+    }
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+    countAllocation(&stats[subsystem], size);
+    countAllocation(&total, size);
+    return header + 1;
+}
+
+/**
+    This function resizes a block returned by allocate(), like realloc(). A NULL pointer
+    allocates a new block for the given subsystem.
+    @param subsystem as the subsystem the block is for
+    @param ptr as the block being resized, or NULL
+    @param size as the new number of bytes needed
+    @return a pointer to the resized block.
+ */
+void *reallocate(Subsystem subsystem, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return allocate(subsystem, size);
+    }
+
+    BlockHeader *header = (BlockHeader *)ptr - 1;
+    size_t oldSize = header->info.size;
+    Subsystem owner = header->info.subsystem;
+    header = (BlockHeader *)allocator.reallocate(header, sizeof(BlockHeader) + size);
+    if (header == NULL)
+    {
+        outOfMemory(size);
+    }
+    header->info.size = size;
+
+    // A resize counts as freeing the old block and allocating the new one
+    countFree(&stats[owner], oldSize);
+    countFree(&total, oldSize);
+    countAllocation(&stats[owner], size);
+    countAllocation(&total, size);
+    return header + 1;
+}
+
+/**
+    This function frees a block returned by allocate() or reallocate(). Freeing NULL does
+    nothing.
+    @param ptr as the block being freed
+ */
+void release(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    BlockHeader *header = (BlockHeader *)ptr - 1;
+    countFree(&stats[header->info.subsystem], header->info.size);
+    countFree(&total, header->info.size);
+    allocator.release(header);
+}
+
+/**
+    This function returns the memory counters for a subsystem.
+    @param subsystem as the subsystem
+    @return the counters.
+ */
+MemoryStats memoryStats(Subsystem subsystem)
+{
+    return stats[subsystem];
+}
+
+/**
+    This function prints the current and peak bytes and the allocation counts of every
+    subsystem, and their totals.
+    @param fp as the stream the report is printed to
+ */
+void printMemoryReport(FILE *fp)
+{
+    fprintf(fp, "%-9s %12s %12s %10s %10s\n", "Subsystem", "Current", "Peak", "Allocs", "Frees");
+    for (int i = 0; i < MEM_SUBSYSTEMS; i++)
+    {
+        MemoryStats counters = memoryStats((Subsystem)i);
+        fprintf(fp, "%-9s %12zu %12zu %10ld %10ld\n", SUBSYSTEM_NAMES[i], counters.current,
+                counters.peak, counters.allocations, counters.frees);
+    }
+    fprintf(fp, "%-9s %12zu %12zu %10ld %10ld\n", "total", total.current, total.peak,
+            total.allocations, total.frees);
+}
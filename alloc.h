@@ -0,0 +1,96 @@
+/**
+    @file alloc.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for alloc.c. The other components get and give back dynamically
+    allocated memory through these functions, so the memory each part of the program uses
+    can be counted and reported.
+*/
+
+/** The parts of the program that memory is counted for */
+typedef enum Subsystem
+{
+    MEM_CATALOG, // Park structs and the lists of parks in the catalog
+    MEM_NAMES,   // Park names
+    MEM_TRIP,    // The trip and its list of parks
+    MEM_QUERY,   // Scratch space used while answering a command
+    MEM_IO,      // Buffers used to read input
+    MEM_OUTPUT,  // Buffers used to write lists of parks
+    MEM_CACHE,   // Cached query results
+    MEM_SUBSYSTEMS
+} Subsystem;
+
+/**
+ * This is the struct for the functions that memory is really allocated with. It lets
+ * the standard library functions be swapped for another allocator.
+ * @param allocate as the function that allocates a block
+ * @param reallocate as the function that resizes a block
+ * @param release as the function that frees a block
+ */
+typedef struct Allocator
+{
+    void *(*allocate)(size_t size);
+    void *(*reallocate)(void *ptr, size_t size);
+    void (*release)(void *ptr);
+} Allocator;
+
+/**
+ * This is the struct for the memory counters of one subsystem.
+ * @param current as the number of bytes allocated right now
+ * @param peak as the most bytes that were ever allocated at once
+ * @param allocations as the number of blocks allocated
+ * @param frees as the number of blocks freed
+ */
+typedef struct MemoryStats
+{
+    size_t current;
+    size_t peak;
+    long allocations;
+    long frees;
+} MemoryStats;
+
+/**
+    This function changes the functions memory is allocated with. It must be called before
+    anything is allocated.
+    @param allocator as the functions to use
+ */
+void setAllocator(Allocator const *allocator);
+
+/**
+    This function allocates a block of memory and counts it against a subsystem. The
+    program exits with an error message if there is no memory left.
+    @param subsystem as the subsystem the block is for
+    @param size as the number of bytes needed
+    @return a pointer to the block.
+ */
+void *allocate(Subsystem subsystem, size_t size);
+
+/**
+    This function resizes a block returned by allocate(), like realloc(). A NULL pointer
+    allocates a new block for the given subsystem.
+    @param subsystem as the subsystem the block is for
+    @param ptr as the block being resized, or NULL
+    @param size as the new number of bytes needed
+    @return a pointer to the resized block.
+ */
+void *reallocate(Subsystem subsystem, void *ptr, size_t size);
+
+/**
+    This function frees a block returned by allocate() or reallocate(). Freeing NULL does
+    nothing.
+    @param ptr as the block being freed
+ */
+void release(void *ptr);
+
+/**
+    This function returns the memory counters for a subsystem.
+    @param subsystem as the subsystem
+    @return the counters.
+ */
+MemoryStats memoryStats(Subsystem subsystem);
+
+/**
+    This function prints the current and peak bytes and the allocation counts of every
+    subsystem, and their totals.
+    @param fp as the stream the report is printed to
+ */
+void printMemoryReport(FILE *fp);
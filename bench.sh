@@ -0,0 +1,48 @@
+#!/bin/bash
+# End-to-end benchmark.  Replays the test inputs and a synthetic mix of
+# commands against parks, and appends the throughput and latency report
+# for each run to bench_output.txt.
+FAIL=0
+SESSIONS=${SESSIONS:-4}
+SYNTHETIC=${SYNTHETIC:-20000}
+
+# Function to run a benchmark.  Expects the park files in the variable, args
+runBench() {
+  NAME=$1
+  shift
+
+  echo "Bench $NAME: ./replay -c $SESSIONS $@ ./parks ${args[@]}" | tee -a bench_output.txt
+  if ! ./replay -c $SESSIONS "$@" ./parks ${args[@]} >> bench_output.txt; then
+      echo "**** FAILED - replay reported an error" | tee -a bench_output.txt
+      FAIL=1
+      return 1
+  fi
+  return 0
+}
+
+# Try to get a fresh compile of the project.
+make clean
+make parks replay
+if [ $? -ne 0 ]; then
+    echo "**** Make didn't run succesfully when trying to build the benchmark."
+    exit 1
+fi
+
+rm -f bench_output.txt
+
+args=(parks-a.txt parks-b.txt parks-c.txt)
+runBench 13 -l input-13.txt
+
+args=(parks-b.txt parks-c.txt)
+runBench 14 -l input-14.txt
+
+args=(parks-a.txt parks-b.txt parks-c.txt)
+runBench synthetic -n $SYNTHETIC
+
+if [ $FAIL -ne 0 ]; then
+  echo "**** There were failing benchmarks"
+  exit 1
+else
+  cat bench_output.txt
+  exit 0
+fi
@@ -0,0 +1,268 @@
+/**
+    @file cache.c
+    @author Samuel E McConnell (semcconn)
+    The cache component keeps the rendered output of repeated read-only queries. Each entry
+    is tagged with the catalog and trip generations it was rendered from, so a change to the
+    trip only drops the entries that depend on the trip. Memory is bounded by evicting the
+    least recently used entries.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cache.h"
+#include "hash.h"
+#include "alloc.h"
+
+/** Marks the end of a list of entry indexes */
+#define NO_ENTRY -1
+
+/**
+    This function takes an entry out of the recently used list.
+    @param cache as the cache
+    @param index as the entry being unlinked
+ */
+static void unlinkEntry(Cache *cache, int index)
+{
+    CacheEntry *entry = &cache->entries[index];
+    if (entry->prev != NO_ENTRY)
+    {
+        cache->entries[entry->prev].next = entry->next;
+    }
+    else
+    {
+        cache->head = entry->next;
+    }
+    if (entry->next != NO_ENTRY)
+    {
+        cache->entries[entry->next].prev = entry->prev;
+    }
+    else
+    {
+        cache->tail = entry->prev;
+    }
+    entry->prev = NO_ENTRY;
+    entry->next = NO_ENTRY;
+}
+
+/**
+    This function puts an entry at the front of the recently used list.
+    @param cache as the cache
+    @param index as the entry that was just used
+ */
+static void pushFront(Cache *cache, int index)
+{
+    CacheEntry *entry = &cache->entries[index];
+    entry->prev = NO_ENTRY;
+    entry->next = cache->head;
+    if (cache->head != NO_ENTRY)
+    {
+        cache->entries[cache->head].prev = index;
+    }
+    cache->head = index;
+    if (cache->tail == NO_ENTRY)
+    {
+        cache->tail = index;
+    }
+}
+
+/**
+    This function removes an entry from the cache and frees its key and output.
+    @param cache as the cache
+    @param index as the entry being removed
+ */
+static void removeEntry(Cache *cache, int index)
+{
+    CacheEntry *entry = &cache->entries[index];
+    int *link = &cache->buckets[hashString(entry->key) % CACHE_BUCKETS];
+    while (*link != index)
+    {
+        link = &cache->entries[*link].chain;
+    }
+    *link = entry->chain;
+
+    unlinkEntry(cache, index);
+    cache->bytes -= entry->length;
+    cache->count--;
+    release(entry->key);
+    release(entry->text);
+    entry->key = NULL;
+    entry->text = NULL;
+    entry->length = 0;
+}
+
+/**
+    This function finds the entry with the given key.
+    @param cache as the cache
+    @param key as the key being searched for
+    @return the index of the entry, or NO_ENTRY if there is none.
+ */
+static int findEntry(Cache *cache, char const *key)
+{
+    for (int i = cache->buckets[hashString(key) % CACHE_BUCKETS]; i != NO_ENTRY; i = cache->entries[i].chain)
+    {
+        if (strcmp(cache->entries[i].key, key) == 0)
+        {
+            return i;
+        }
+    }
+    return NO_ENTRY;
+}
+
+/**
+ * This function dynamically allocates storage for an empty Cache and returns a pointer
+ * to it.
+ * @return the cache that it constructed.
+ */
+Cache *makeCache()
+{
+    Cache *cache = (Cache *)allocate(MEM_CACHE, sizeof(Cache));
+    for (int i = 0; i < CACHE_MAX_ENTRIES; i++)
+    {
+        cache->entries[i].key = NULL;
+        cache->entries[i].text = NULL;
+        cache->entries[i].length = 0;
+        cache->entries[i].prev = NO_ENTRY;
+        cache->entries[i].next = NO_ENTRY;
+        cache->entries[i].chain = NO_ENTRY;
+    }
+    for (int i = 0; i < CACHE_BUCKETS; i++)
+    {
+        cache->buckets[i] = NO_ENTRY;
+    }
+    cache->head = NO_ENTRY;
+    cache->tail = NO_ENTRY;
+    cache->count = 0;
+    cache->bytes = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->invalidations = 0;
+    cache->evictions = 0;
+    return cache;
+}
+
+/**
+    This function frees the memory used by the given Cache, including every cached result.
+    @param cache as the cache being freed
+ */
+void freeCache(Cache *cache)
+{
+    for (int i = 0; i < CACHE_MAX_ENTRIES; i++)
+    {
+        release(cache->entries[i].key);
+        release(cache->entries[i].text);
+    }
+    release(cache);
+}
+
+/**
+    This function looks up the rendered output for the given key. An entry only counts as
+    found if it was rendered from the current catalog generation and, when it depends on
+    the trip, from the current trip generation. Stale entries are dropped.
+    @param cache as the cache being searched
+    @param key as the command and arguments being looked up
+    @param catalogGeneration as the current catalog generation
+    @param tripGeneration as the current trip generation
+    @param length as where the length of the output is stored
+    @return the rendered output, or NULL if there is no current entry.
+ */
+char const *cacheLookup(Cache *cache, char const *key, unsigned long catalogGeneration,
+                        unsigned long tripGeneration, size_t *length)
+{
+    int index = findEntry(cache, key);
+    if (index == NO_ENTRY)
+    {
+        cache->misses++;
+        return NULL;
+    }
+
+    CacheEntry *entry = &cache->entries[index];
+    if (entry->catalogGeneration != catalogGeneration ||
+        (entry->usesTrip && entry->tripGeneration != tripGeneration))
+    {
+        removeEntry(cache, index);
+        cache->invalidations++;
+        cache->misses++;
+        return NULL;
+    }
+
+    unlinkEntry(cache, index);
+    pushFront(cache, index);
+    cache->hits++;
+    *length = entry->length;
+    return entry->text;
+}
+
+/**
+    This function stores a copy of rendered output for the given key. Least recently used
+    entries are evicted to stay under the entry and byte limits, and output larger than the
+    byte limit is not cached at all.
+    @param cache as the cache being added to
+    @param key as the command and arguments the output was rendered for
+    @param text as the rendered output
+    @param length as the number of bytes in text
+    @param catalogGeneration as the catalog generation the output was rendered from
+    @param tripGeneration as the trip generation the output was rendered from
+    @param usesTrip as true if the output depends on the trip
+ */
+void cacheStore(Cache *cache, char const *key, char const *text, size_t length,
+                unsigned long catalogGeneration, unsigned long tripGeneration, bool usesTrip)
+{
+    int index = findEntry(cache, key);
+    if (index != NO_ENTRY)
+    {
+        removeEntry(cache, index);
+    }
+    if (length > CACHE_MAX_BYTES)
+    {
+        return;
+    }
+
+    while (cache->count == CACHE_MAX_ENTRIES || cache->bytes + length > CACHE_MAX_BYTES)
+    {
+        removeEntry(cache, cache->tail);
+        cache->evictions++;
+    }
+
+    index = 0;
+    while (cache->entries[index].key != NULL)
+    {
+        index++;
+    }
+
+    CacheEntry *entry = &cache->entries[index];
+    entry->key = (char *)allocate(MEM_CACHE, strlen(key) + 1);
+    strcpy(entry->key, key);
+    entry->text = (char *)allocate(MEM_CACHE, length);
+    memcpy(entry->text, text, length);
+    entry->length = length;
+    entry->catalogGeneration = catalogGeneration;
+    entry->tripGeneration = tripGeneration;
+    entry->usesTrip = usesTrip;
+
+    int bucket = hashString(key) % CACHE_BUCKETS;
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+    pushFront(cache, index);
+    cache->count++;
+    cache->bytes += length;
+}
+
+/**
+    This function prints the hit and miss counters of the cache.
+    @param fp as the stream the counters are printed to
+    @param cache as the cache being reported on
+ */
+void printCacheStats(FILE *fp, Cache *cache)
+{
+    long lookups = cache->hits + cache->misses;
+    double rate = lookups > 0 ? 100.0 * cache->hits / lookups : 0.0;
+    fprintf(fp, "%-13s %ld\n", "Hits", cache->hits);
+    fprintf(fp, "%-13s %ld\n", "Misses", cache->misses);
+    fprintf(fp, "%-13s %.1f%%\n", "Hit rate", rate);
+    fprintf(fp, "%-13s %d\n", "Entries", cache->count);
+    fprintf(fp, "%-13s %zu\n", "Bytes", cache->bytes);
+    fprintf(fp, "%-13s %ld\n", "Invalidations", cache->invalidations);
+    fprintf(fp, "%-13s %ld\n", "Evictions", cache->evictions);
+}
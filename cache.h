@@ -0,0 +1,118 @@
+/**
+    @file cache.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for cache.c. This file lets the other components keep the
+    rendered output of read-only queries so repeated queries do not rescan the catalog.
+*/
+
+/** The max number of query results the cache can hold */
+#define CACHE_MAX_ENTRIES 64
+/** The max number of bytes of rendered output the cache can hold */
+#define CACHE_MAX_BYTES (1024 * 1024)
+/** Queries that can list more parks than this are not cached, since their output would
+    rarely fit */
+#define CACHE_MAX_ROWS 8192
+/** The number of hash buckets used to find cache entries */
+#define CACHE_BUCKETS 128
+
+/**
+ * This is the struct for one cached query result.
+ * @param key as the command and arguments the result was rendered for
+ * @param text as the rendered output
+ * @param length as the number of bytes in text
+ * @param catalogGeneration as the catalog generation the result was rendered from
+ * @param tripGeneration as the trip generation the result was rendered from
+ * @param usesTrip as true if the result depends on the trip
+ * @param prev as the index of the next more recently used entry
+ * @param next as the index of the next less recently used entry
+ * @param chain as the index of the next entry in the same hash bucket
+ */
+typedef struct CacheEntry
+{
+    char *key;
+    char *text;
+    size_t length;
+    unsigned long catalogGeneration;
+    unsigned long tripGeneration;
+    bool usesTrip;
+    int prev;
+    int next;
+    int chain;
+} CacheEntry;
+
+/**
+ * This is the struct for the cache. Entries are kept in a fixed table, found through
+ * hash buckets and ordered from most to least recently used for eviction.
+ * @param entries as the table of entries, unused entries have a NULL key
+ * @param buckets as the first entry index for each hash bucket
+ * @param head as the most recently used entry
+ * @param tail as the least recently used entry
+ * @param count as the number of entries in use
+ * @param bytes as the number of bytes of rendered output held
+ * @param hits as the number of lookups that found a current entry
+ * @param misses as the number of lookups that did not
+ * @param invalidations as the number of entries dropped because they were stale
+ * @param evictions as the number of entries dropped to stay under the limits
+ */
+typedef struct Cache
+{
+    CacheEntry entries[CACHE_MAX_ENTRIES];
+    int buckets[CACHE_BUCKETS];
+    int head;
+    int tail;
+    int count;
+    size_t bytes;
+    long hits;
+    long misses;
+    long invalidations;
+    long evictions;
+} Cache;
+
+/**
+ * This function dynamically allocates storage for an empty Cache and returns a pointer
+ * to it.
+ * @return the cache that it constructed.
+ */
+Cache *makeCache();
+
+/**
+    This function frees the memory used by the given Cache, including every cached result.
+    @param cache as the cache being freed
+ */
+void freeCache(Cache *cache);
+
+/**
+    This function looks up the rendered output for the given key. An entry only counts as
+    found if it was rendered from the current catalog generation and, when it depends on
+    the trip, from the current trip generation. Stale entries are dropped.
+    @param cache as the cache being searched
+    @param key as the command and arguments being looked up
+    @param catalogGeneration as the current catalog generation
+    @param tripGeneration as the current trip generation
+    @param length as where the length of the output is stored
+    @return the rendered output, or NULL if there is no current entry.
+ */
+char const *cacheLookup(Cache *cache, char const *key, unsigned long catalogGeneration,
+                        unsigned long tripGeneration, size_t *length);
+
+/**
+    This function stores a copy of rendered output for the given key. Least recently used
+    entries are evicted to stay under the entry and byte limits, and output larger than the
+    byte limit is not cached at all.
+    @param cache as the cache being added to
+    @param key as the command and arguments the output was rendered for
+    @param text as the rendered output
+    @param length as the number of bytes in text
+    @param catalogGeneration as the catalog generation the output was rendered from
+    @param tripGeneration as the trip generation the output was rendered from
+    @param usesTrip as true if the output depends on the trip
+ */
+void cacheStore(Cache *cache, char const *key, char const *text, size_t length,
+                unsigned long catalogGeneration, unsigned long tripGeneration, bool usesTrip);
+
+/**
+    This function prints the hit and miss counters of the cache.
+    @param fp as the stream the counters are printed to
+    @param cache as the cache being reported on
+ */
+void printCacheStats(FILE *fp, Cache *cache);
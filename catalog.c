@@ -11,8 +11,15 @@
 #include <string.h>
 #include <math.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "input.h"
+#include "output.h"
 #include "catalog.h"
+#include "alloc.h"
+#include "hash.h"
 
 /** Multiplier for converting degrees to radians */
 #define DEG_TO_RAD (M_PI / 180)
@@ -20,6 +27,37 @@
 /** Radius of the earth in miles. */
 #define EARTH_RADIUS 3959.0
 
+/** The longest number the slow path of parseDouble() will convert */
+#define MAX_NUMBER_LENGTH 64
+
+/**
+ * This function computes the point on a unit sphere for a park's global coordinates.
+ * @param park as a pointer to a park.
+ * @param v as the array of 3 doubles the point is stored in.
+ */
+void unitVector(Park const *park, double v[])
+{
+    v[0] = cos(park->lon * DEG_TO_RAD) * cos(park->lat * DEG_TO_RAD);
+    v[1] = sin(park->lon * DEG_TO_RAD) * cos(park->lat * DEG_TO_RAD);
+    v[2] = sin(park->lat * DEG_TO_RAD);
+}
+
+/**
+ * This function turns the dot product of two unit vectors into the distance in miles
+ * between the points on the earth they stand for.
+ * @param dp as the dot product.
+ * @return the distance in miles.
+ */
+double arcDistance(double dp)
+{
+    if (dp > 1)
+    {
+        return 0;
+    }
+    double angle = acos(dp);
+    return EARTH_RADIUS * angle;
+}
+
 /**
  * This returns the distance in miles between two parks. It computes this
  * distance based on the Parks’ global coordinates.
@@ -29,30 +67,17 @@
  */
 double distance(Park const *a, Park const *b)
 {
-    double lat1 = a->lat;
-    double lon1 = a->lon;
-    double lat2 = b->lat;
-    double lon2 = b->lon;
-
-    double v1[] = {cos(lon1 * DEG_TO_RAD) * cos(lat1 * DEG_TO_RAD),
-                   sin(lon1 * DEG_TO_RAD) * cos(lat1 * DEG_TO_RAD),
-                   sin(lat1 * DEG_TO_RAD)};
-
-    double v2[] = {cos(lon2 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD),
-                   sin(lon2 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD),
-                   sin(lat2 * DEG_TO_RAD)};
+    double v1[3];
+    double v2[3];
+    unitVector(a, v1);
+    unitVector(b, v2);
 
     double dp = 0.0;
     for (int i = 0; i < sizeof(v1) / sizeof(v1[0]); i++)
     {
         dp += v1[i] * v2[i];
     }
-    if (dp > 1)
-    {
-        return 0;
-    }
-    double angle = acos(dp);
-    return EARTH_RADIUS * angle;
+    return arcDistance(dp);
 }
 /**
  * This function dynamically allocates storage for the Catalog, initializes its
@@ -62,10 +87,16 @@ double distance(Park const *a, Park const *b)
  */
 Catalog *makeCatalog()
 {
-    Catalog *catalog = (Catalog *)malloc(sizeof(Catalog));
-    catalog->parks = (Park **)malloc(sizeof(Park *) * INITIAL_CAPACITY);
+    Catalog *catalog = (Catalog *)allocate(MEM_CATALOG, sizeof(Catalog));
+    catalog->byFile = (Park **)allocate(MEM_CATALOG, sizeof(Park *) * INITIAL_CAPACITY);
+    catalog->parks = catalog->byFile;
     catalog->count = 0;
     catalog->capacity = INITIAL_CAPACITY;
+    catalog->generation = 0;
+    catalog->store = NULL;
+    catalog->byId = NULL;
+    catalog->byName = NULL;
+    catalog->rank = NULL;
     return catalog;
 }
 
@@ -79,15 +110,250 @@ void freeCatalog(Catalog *catalog)
 {
     for (int i = 0; i < catalog->count; i++)
     {
-        if (catalog->parks[i] != NULL)
+        if (catalog->byFile[i] != NULL)
+        {
+            release(catalog->byFile[i]->name);
+            if (catalog->store == NULL)
+            {
+                release(catalog->byFile[i]);
+            }
+            catalog->byFile[i] = NULL;
+        }
+    }
+    release(catalog->store);
+    release(catalog->byFile);
+    release(catalog->byId);
+    release(catalog->byName);
+    release(catalog->rank);
+    release(catalog);
+}
+
+/** Powers of ten that a double can hold exactly */
+static const double EXACT_POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                             1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+                                             1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/** The largest power of ten in EXACT_POWERS_OF_TEN */
+#define MAX_EXACT_POWER 22
+
+/** The largest mantissa a double can hold exactly, 2^53 */
+#define MAX_EXACT_MANTISSA 9007199254740992ULL
+
+/**
+    This function parses a whole field as a decimal integer with an optional sign.
+    @param start as the first character of the field
+    @param end as one past the last character of the field
+    @param value as where the integer is stored
+    @return true if the whole field is an integer that fits in an int.
+ */
+static bool parseInteger(char const *start, char const *end, int *value)
+{
+    char const *p = start;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end)
+    {
+        return false;
+    }
+
+    long long number = 0;
+    for (; p < end; p++)
+    {
+        if (*p < '0' || *p > '9')
         {
-            free(catalog->parks[i]->name);
-            free(catalog->parks[i]);
-            catalog->parks[i] = NULL;
+            return false;
+        }
+        number = number * 10 + (*p - '0');
+        if (number > (long long)INT_MAX + 1)
+        {
+            return false;
         }
     }
-    free(catalog->parks);
-    free(catalog);
+    if (negative)
+    {
+        number = -number;
+    }
+    if (number > INT_MAX)
+    {
+        return false;
+    }
+    *value = (int)number;
+    return true;
+}
+
+/**
+    This function parses a whole field as a decimal floating point number. Numbers with at
+    most 15 significant digits and a small exponent are converted exactly with one multiply
+    or divide, which gives the same correctly rounded result as strtod(). Anything else is
+    handed to strtod().
+    @param start as the first character of the field
+    @param end as one past the last character of the field
+    @param value as where the number is stored
+    @return true if the whole field is a number.
+ */
+static bool parseDouble(char const *start, char const *end, double *value)
+{
+    char const *p = start;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool seenDigit = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        seenDigit = true;
+        if (mantissa != 0 || *p != '0')
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits++;
+        }
+        if (digits > 15)
+        {
+            break;
+        }
+    }
+    if (p < end && *p == '.' && digits <= 15)
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            seenDigit = true;
+            if (mantissa != 0 || *p != '0')
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits++;
+            }
+            exponent--;
+            if (digits > 15)
+            {
+                break;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E') && seenDigit && digits <= 15)
+    {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        int power = 0;
+        bool seenExponent = false;
+        for (; p < end && *p >= '0' && *p <= '9' && power < 10000; p++)
+        {
+            seenExponent = true;
+            power = power * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -power : power;
+        seenDigit = seenExponent;
+    }
+
+    if (p == end && seenDigit && digits <= 15 && mantissa <= MAX_EXACT_MANTISSA &&
+        exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER)
+    {
+        double number = (double)mantissa;
+        if (exponent < 0)
+        {
+            number /= EXACT_POWERS_OF_TEN[-exponent];
+        }
+        else
+        {
+            number *= EXACT_POWERS_OF_TEN[exponent];
+        }
+        *value = negative ? -number : number;
+        return true;
+    }
+
+    // Long, unusual or malformed numbers take the slow path
+    char field[MAX_NUMBER_LENGTH + 1];
+    size_t length = end - start;
+    if (length == 0 || length > MAX_NUMBER_LENGTH)
+    {
+        return false;
+    }
+    memcpy(field, start, length);
+    field[length] = '\0';
+    char *stop;
+    *value = strtod(field, &stop);
+    return stop == field + length;
+}
+
+/**
+    This function parses the first line of a park record, which holds the ID, latitude,
+    longitude and counties separated by single spaces. It walks the line once, finding
+    each space with memchr() and converting each field where it sits.
+    @param line as the line being parsed
+    @param length as the number of characters in the line
+    @param park as the park the fields are stored in
+    @return true if the line is a valid park record.
+ */
+bool parseParkRecord(char const *line, size_t length, Park *park)
+{
+    char const *end = line + length;
+
+    char const *space = memchr(line, ' ', length);
+    if (space == NULL || !parseInteger(line, space, &park->id))
+    {
+        return false;
+    }
+
+    char const *field = space + 1;
+    space = memchr(field, ' ', end - field);
+    if (space == NULL || !parseDouble(field, space, &park->lat))
+    {
+        return false;
+    }
+
+    field = space + 1;
+    space = memchr(field, ' ', end - field);
+    if (space == NULL || !parseDouble(field, space, &park->lon))
+    {
+        return false;
+    }
+
+    int countyCount = 0;
+    field = space + 1;
+    while (1)
+    {
+        space = memchr(field, ' ', end - field);
+        char const *stop = (space != NULL) ? space : end;
+        size_t nameLength = stop - field;
+        // A trailing space leaves an empty last field, which older files have and is ignored
+        if (space == NULL && nameLength == 0 && countyCount > 0)
+        {
+            break;
+        }
+        // An empty county anywhere else would end the list early, so it is an error
+        if ((nameLength == 0 && countyCount > 0) || nameLength > MAX_COUNTIES_NAME_LENGTH ||
+            countyCount == MAX_COUNTIES)
+        {
+            return false;
+        }
+        memcpy(park->counties[countyCount], field, nameLength);
+        park->counties[countyCount][nameLength] = '\0';
+        countyCount++;
+        if (space == NULL)
+        {
+            break;
+        }
+        field = space + 1;
+    }
+    if (countyCount < MAX_COUNTIES)
+    {
+        park->counties[countyCount][0] = '\0';
+    }
+    return true;
 }
 
 /**
@@ -99,119 +365,257 @@ void freeCatalog(Catalog *catalog)
  */
 void readParks(char const *filename, Catalog *catalog)
 {
-    FILE *fp = fopen(filename, "r");
-    if (fp == NULL)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
     {
         fprintf(stderr, "Can't open file: %s\n", filename);
         exit(EXIT_FAILURE);
     }
 
+    LineReader *reader = makeLineReader(fd);
     char *line;
-    while ((line = readLine(fp)) != NULL)
+    size_t length;
+    while ((line = nextLine(reader, &length)) != NULL)
     {
 
         if (catalog->count == catalog->capacity)
         {
             catalog->capacity *= 2;
-            Park **newParks = realloc(catalog->parks, sizeof(Park *) * catalog->capacity);
-            if (!newParks)
-            {
-                fprintf(stderr, "Invalid park file: %s\n", filename);
-                exit(EXIT_FAILURE);
-            }
+            Park **newParks = reallocate(MEM_CATALOG, catalog->byFile, sizeof(Park *) * catalog->capacity);
+            catalog->byFile = newParks;
             catalog->parks = newParks;
         }
 
-        Park *park = (Park *)malloc(sizeof(Park));
-        int id;
-        double longitude, latitude;
-        if (sscanf(line, "%d %lf %lf", &id, &latitude, &longitude) != 3)
+        Park *park = (Park *)allocate(MEM_CATALOG, sizeof(Park));
+        if (!parseParkRecord(line, length, park))
         {
             fprintf(stderr, "Invalid park file: %s\n", filename);
             exit(EXIT_FAILURE);
         }
         for (int i = 0; i < catalog->count; i++)
         {
-            if (catalog->parks[i]->id == id)
+            if (catalog->byFile[i]->id == park->id)
             {
                 fprintf(stderr, "Invalid park file: %s\n", filename);
                 exit(EXIT_FAILURE);
             }
         }
 
-        park->id = id;
-        park->lat = latitude;
-        park->lon = longitude;
+        size_t nameLength;
+        char *name = nextLine(reader, &nameLength);
+        if (name == NULL || nameLength > MAX_NAME_LENGTH)
+        {
+            fprintf(stderr, "Invalid park file: %s\n", filename);
+            exit(EXIT_FAILURE);
+        }
+        // Names are copied out of the line buffer so they only take the space they need
+        park->name = (char *)allocate(MEM_NAMES, nameLength + 1);
+        memcpy(park->name, name, nameLength + 1);
+        catalog->byFile[catalog->count] = park;
+        catalog->count++;
+    }
+    freeLineReader(reader);
+    close(fd);
+    catalog->generation++;
+}
+
+/**
+ * This is the struct used to sort parks along the Hilbert curve.
+ * @param key as the distance along the curve
+ * @param index as the position of the park in the file order
+ */
+typedef struct HilbertKey
+{
+    unsigned long key;
+    int index;
+} HilbertKey;
 
-        int spaceCount = 0;
-        int i = 0;
-        while (spaceCount < 3)
+/**
+    This function returns how far along a Hilbert curve a cell of the grid is. Cells
+    that are close along the curve are also close on the grid.
+    @param x as the column of the cell
+    @param y as the row of the cell
+    @return the distance along the curve.
+ */
+static unsigned long hilbertIndex(unsigned int x, unsigned int y)
+{
+    unsigned long d = 0;
+    for (unsigned int s = HILBERT_SIZE / 2; s > 0; s /= 2)
+    {
+        unsigned int rx = (x & s) > 0;
+        unsigned int ry = (y & s) > 0;
+        d += (unsigned long)s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
         {
-            if (line[i] == ' ')
+            if (rx == 1)
             {
-                spaceCount++;
+                x = HILBERT_SIZE - 1 - x;
+                y = HILBERT_SIZE - 1 - y;
             }
-            i++;
+            unsigned int t = x;
+            x = y;
+            y = t;
         }
+    }
+    return d;
+}
+
+/**
+    This function maps a coordinate onto a row or column of the Hilbert grid.
+    @param value as the coordinate
+    @param low as the smallest coordinate in the catalog
+    @param high as the largest coordinate in the catalog
+    @return the row or column.
+ */
+static unsigned int gridCell(double value, double low, double high)
+{
+    if (high <= low)
+    {
+        return 0;
+    }
+    // Coordinates that are not finite, or so far apart the range overflows, go in cell 0
+    double cell = (value - low) / (high - low) * (HILBERT_SIZE - 1);
+    if (!(cell >= 0))
+    {
+        return 0;
+    }
+    return cell > HILBERT_SIZE - 1 ? HILBERT_SIZE - 1 : (unsigned int)cell;
+}
+
+/**
+    This function compares two parks by their distance along the Hilbert curve, breaking
+    ties by the order they were read in.
+    @param a as a key being compared
+    @param b as a key being compared
+    @return an int value to sort.
+ */
+static int compareHilbertKeys(const void *a, const void *b)
+{
+    HilbertKey const *keyA = (HilbertKey const *)a;
+    HilbertKey const *keyB = (HilbertKey const *)b;
+    if (keyA->key != keyB->key)
+    {
+        return (keyA->key < keyB->key) ? -1 : 1;
+    }
+    return (keyA->index < keyB->index) ? -1 : (keyA->index > keyB->index);
+}
 
-        int length = strlen(line) - i;
-        char *counties = (char *)malloc(length + 1);
-        strncpy(counties, line + i, length);
-        counties[length] = '\0';
-        length = strlen(counties);
+/**
+    This function builds a sorted copy of the file order list of parks.
+    @param catalog as the catalog
+    @param compare as the compare method being used
+    @return the sorted list.
+ */
+static Park **sortedView(Catalog *catalog, int (*compare)(void const *va, void const *vb))
+{
+    Park **view = (Park **)allocate(MEM_CATALOG, sizeof(Park *) * catalog->count);
+    memcpy(view, catalog->byFile, sizeof(Park *) * catalog->count);
+    catalog->parks = view;
+    sortParks(catalog, compare);
+    return view;
+}
 
-        int j = 0;
-        int countyCount = 0;
-        int countyNameLength = 0;
-        char eachCounty[MAX_COUNTIES_NAME_LENGTH + 1];
-        while (j <= length)
+/**
+    This function moves the parks into one block ordered along a Hilbert curve over their
+    latitude and longitude, and builds the lists of parks sorted by ID and by name. It is
+    called once after all park files are read, before any park is added to a trip.
+    @param catalog as the catalog being indexed
+    @param compareById as the compare method for sorting by ID
+    @param compareByName as the compare method for sorting by name
+ */
+void indexCatalog(Catalog *catalog, int (*compareById)(void const *va, void const *vb),
+                  int (*compareByName)(void const *va, void const *vb))
+{
+    int count = catalog->count;
+    // The bounds only cover finite coordinates, which the parser does not insist on
+    double minLat = 0, maxLat = 0, minLon = 0, maxLon = 0;
+    bool seenLat = false, seenLon = false;
+    for (int i = 0; i < count; i++)
+    {
+        Park *park = catalog->byFile[i];
+        if (isfinite(park->lat))
         {
-            if (counties[j] == ' ' || counties[j] == '\0')
-            {
-                eachCounty[countyNameLength] = '\0';
-                if (countyNameLength > MAX_COUNTIES_NAME_LENGTH)
-                {
-                    fprintf(stderr, "Invalid park file: %s\n", filename);
-                    exit(EXIT_FAILURE);
-                }
-                strcpy(park->counties[countyCount], eachCounty);
-                for (int x = 0; x < countyNameLength; x++)
-                {
-                    eachCounty[x] = '\0';
-                }
-
-                countyCount++;
-                if (countyCount > MAX_COUNTIES)
-                {
-                    fprintf(stderr, "Invalid park file: %s\n", filename);
-                    exit(EXIT_FAILURE);
-                }
-
-                if (counties[j] == '\0' || counties[j] == '\n')
-                {
-                    strcpy(park->counties[countyCount], "\0");
-                    break;
-                }
-                j++;
-                countyNameLength = 0;
-            }
-            eachCounty[countyNameLength] = counties[j];
-            j++;
-            countyNameLength++;
+            minLat = (!seenLat || park->lat < minLat) ? park->lat : minLat;
+            maxLat = (!seenLat || park->lat > maxLat) ? park->lat : maxLat;
+            seenLat = true;
         }
+        if (isfinite(park->lon))
+        {
+            minLon = (!seenLon || park->lon < minLon) ? park->lon : minLon;
+            maxLon = (!seenLon || park->lon > maxLon) ? park->lon : maxLon;
+            seenLon = true;
+        }
+    }
 
-        park->name = readLine(fp);
-        free(line);
-        free(counties);
-        if (strlen(park->name) > MAX_NAME_LENGTH)
+    HilbertKey *keys = (HilbertKey *)allocate(MEM_QUERY, sizeof(HilbertKey) * count);
+    for (int i = 0; i < count; i++)
+    {
+        Park *park = catalog->byFile[i];
+        keys[i].key = hilbertIndex(gridCell(park->lon, minLon, maxLon),
+                                   gridCell(park->lat, minLat, maxLat));
+        keys[i].index = i;
+    }
+    qsort(keys, count, sizeof(HilbertKey), compareHilbertKeys);
+
+    catalog->store = (Park *)allocate(MEM_CATALOG, sizeof(Park) * count);
+    for (int i = 0; i < count; i++)
+    {
+        Park *park = catalog->byFile[keys[i].index];
+        catalog->store[i] = *park;
+        release(park);
+        catalog->byFile[keys[i].index] = &catalog->store[i];
+    }
+    release(keys);
+
+    catalog->byId = sortedView(catalog, compareById);
+    catalog->byName = sortedView(catalog, compareByName);
+    catalog->rank = (int *)allocate(MEM_CATALOG, sizeof(int) * count);
+    viewParks(catalog, catalog->byFile);
+}
+
+/**
+    This function chooses which list of parks the catalog is listed in, without sorting.
+    @param catalog as the catalog
+    @param view as catalog->byFile, catalog->byId or catalog->byName
+ */
+void viewParks(Catalog *catalog, Park **view)
+{
+    catalog->parks = view;
+    for (int i = 0; i < catalog->count; i++)
+    {
+        catalog->rank[view[i] - catalog->store] = i;
+    }
+}
+
+/**
+    This function finds the park with the given ID by binary search over the parks sorted
+    by ID, so it must be called after indexCatalog().
+    @param catalog as the catalog
+    @param id as the ID of the park
+    @return the park, or NULL if there is no park with that ID.
+ */
+Park *findPark(Catalog const *catalog, int id)
+{
+    int low = 0;
+    int high = catalog->count - 1;
+    while (low <= high)
+    {
+        int mid = low + (high - low) / 2;
+        Park *park = catalog->byId[mid];
+        if (park->id == id)
         {
-            fprintf(stderr, "Invalid park file: %s\n", filename);
-            exit(EXIT_FAILURE);
+            return park;
+        }
+        if (park->id < id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
         }
-        catalog->parks[catalog->count] = park;
-        catalog->count++;
     }
-    fclose(fp);
+    return NULL;
 }
 
 /**
@@ -229,42 +633,305 @@ void sortParks(Catalog *catalog, int (*compare)(void const *va, void const *vb))
     qsort(catalog->parks, catalog->count, sizeof(Park *), compare);
 }
 
+/** The number of slots the county table starts with, a power of two */
+#define COUNTY_TABLE_SIZE 256
+
+/**
+ * This is the struct for the table that gives each county name an ID in binary output.
+ * @param names as the county names, in ID order
+ * @param slots as the hash table of IDs, -1 for an empty slot
+ * @param count as the number of counties
+ * @param capacity as the number of slots
+ */
+typedef struct CountyTable
+{
+    char (*names)[MAX_COUNTIES_NAME_LENGTH + 1];
+    int *slots;
+    int count;
+    int capacity;
+} CountyTable;
+
+/**
+    This function sets up the hash table slots of a county table for the names it holds.
+    @param table as the county table
+    @param capacity as the number of slots
+ */
+static void fillCountySlots(CountyTable *table, int capacity)
+{
+    release(table->slots);
+    table->capacity = capacity;
+    table->slots = (int *)allocate(MEM_QUERY, sizeof(int) * capacity);
+    table->names = reallocate(MEM_QUERY, table->names, sizeof(table->names[0]) * (capacity / 2));
+    for (int i = 0; i < capacity; i++)
+    {
+        table->slots[i] = -1;
+    }
+    for (int id = 0; id < table->count; id++)
+    {
+        unsigned long slot = hashString(table->names[id]) & (capacity - 1);
+        while (table->slots[slot] != -1)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table->slots[slot] = id;
+    }
+}
+
+/**
+    This function returns the ID of a county, giving it the next ID if it is new.
+    @param table as the county table
+    @param name as the county name
+    @return the ID.
+ */
+static int countyId(CountyTable *table, char const *name)
+{
+    if (table->count * 2 >= table->capacity)
+    {
+        fillCountySlots(table, table->capacity * 2);
+    }
+    unsigned long slot = hashString(name) & (table->capacity - 1);
+    while (table->slots[slot] != -1)
+    {
+        if (strcmp(table->names[table->slots[slot]], name) == 0)
+        {
+            return table->slots[slot];
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    strcpy(table->names[table->count], name);
+    table->slots[slot] = table->count;
+    table->count++;
+    return table->count - 1;
+}
+
+/**
+    This function writes one block of parks as binary column output.
+    @param writer as the writer
+    @param rows as the parks in the block
+    @param count as the number of parks in the block
+    @param table as the county table, which the new counties are added to
+    @param column as scratch space for OUTPUT_BLOCK_ROWS doubles
+    @param counties as scratch space for OUTPUT_BLOCK_ROWS * MAX_COUNTIES county IDs
+ */
+static void writeParkBlock(Writer *writer, Park **rows, int count, CountyTable *table,
+                           void *column, uint32_t *counties)
+{
+    writeInt32(writer, count);
+
+    int firstNew = table->count;
+    for (int r = 0; r < count; r++)
+    {
+        bool ended = false;
+        for (int c = 0; c < MAX_COUNTIES; c++)
+        {
+            ended = ended || rows[r]->counties[c][0] == '\0';
+            counties[r * MAX_COUNTIES + c] = ended ? NO_COUNTY : countyId(table, rows[r]->counties[c]);
+        }
+    }
+    writeInt32(writer, table->count - firstNew);
+    for (int id = firstNew; id < table->count; id++)
+    {
+        unsigned char length = strlen(table->names[id]);
+        writeBytes(writer, &length, 1);
+        writeBytes(writer, table->names[id], length);
+    }
+
+    int32_t *ids = (int32_t *)column;
+    for (int r = 0; r < count; r++)
+    {
+        ids[r] = rows[r]->id;
+    }
+    writeBytes(writer, ids, sizeof(int32_t) * count);
+
+    double *values = (double *)column;
+    for (int r = 0; r < count; r++)
+    {
+        values[r] = rows[r]->lat;
+    }
+    writeBytes(writer, values, sizeof(double) * count);
+    for (int r = 0; r < count; r++)
+    {
+        values[r] = rows[r]->lon;
+    }
+    writeBytes(writer, values, sizeof(double) * count);
+
+    char const **names = (char const **)column;
+    for (int r = 0; r < count; r++)
+    {
+        names[r] = rows[r]->name;
+    }
+    writeNameColumn(writer, names, count);
+
+    writeBytes(writer, counties, sizeof(uint32_t) * MAX_COUNTIES * count);
+}
+
+/**
+    This function writes the parks that pass the test as binary column output, a block of
+    OUTPUT_BLOCK_ROWS parks at a time.
+    @param writer as the writer
+    @param catalog as the catalog being written
+    @param test as the helper method to help with making sure a park has the specific county
+    @param str as a const pointer to the county, or NULL for every park
+ */
+static void writeParkBlocks(Writer *writer, Catalog *catalog,
+                            bool (*test)(Park const *park, char const *str), char const *str)
+{
+    CountyTable table = {NULL, NULL, 0, 0};
+    fillCountySlots(&table, COUNTY_TABLE_SIZE);
+    Park **rows = (Park **)allocate(MEM_QUERY, sizeof(Park *) * OUTPUT_BLOCK_ROWS);
+    void *column = allocate(MEM_QUERY, sizeof(double) * OUTPUT_BLOCK_ROWS);
+    uint32_t *counties = (uint32_t *)allocate(MEM_QUERY, sizeof(uint32_t) * MAX_COUNTIES * OUTPUT_BLOCK_ROWS);
+
+    writeBytes(writer, OUTPUT_PARKS_MAGIC, 4);
+    writeInt32(writer, OUTPUT_VERSION);
+    int count = 0;
+    for (int i = 0; i < catalog->count; i++)
+    {
+        Park *park = catalog->parks[i];
+        if (str == NULL || test(park, str))
+        {
+            rows[count++] = park;
+            if (count == OUTPUT_BLOCK_ROWS)
+            {
+                writeParkBlock(writer, rows, count, &table, column, counties);
+                count = 0;
+            }
+        }
+    }
+    if (count > 0)
+    {
+        writeParkBlock(writer, rows, count, &table, column, counties);
+    }
+    writeInt32(writer, 0);
+
+    release(rows);
+    release(column);
+    release(counties);
+    release(table.names);
+    release(table.slots);
+}
+
+/**
+    This function writes one park as a row of text, CSV or JSON output.
+    @param writer as the writer
+    @param park as the park being written
+    @param format as the output format
+ */
+static void writeParkRow(Writer *writer, Park const *park, OutputFormat format)
+{
+    int countyCount = 0;
+    while (countyCount < MAX_COUNTIES && park->counties[countyCount][0] != '\0')
+    {
+        countyCount++;
+    }
+
+    if (format == OUTPUT_TEXT)
+    {
+        writeInteger(writer, park->id, 3, true);
+        writeText(writer, " ");
+        writePadded(writer, park->name, MAX_NAME_LENGTH, true);
+        writeText(writer, " ");
+        writeFixed(writer, park->lat, 8, 3);
+        writeText(writer, " ");
+        writeFixed(writer, park->lon, 8, 3);
+        writeText(writer, " ");
+        for (int j = 0; j < countyCount; j++)
+        {
+            writeText(writer, j > 0 ? "," : "");
+            writeText(writer, park->counties[j]);
+        }
+        writeText(writer, "\n");
+    }
+    else if (format == OUTPUT_CSV)
+    {
+        char counties[MAX_COUNTIES * (MAX_COUNTIES_NAME_LENGTH + 1) + 1] = "";
+        for (int j = 0; j < countyCount; j++)
+        {
+            strcat(counties, j > 0 ? "," : "");
+            strcat(counties, park->counties[j]);
+        }
+        writeInteger(writer, park->id, 0, true);
+        writeText(writer, ",");
+        writeCsvField(writer, park->name);
+        writeText(writer, ",");
+        writeNumber(writer, park->lat);
+        writeText(writer, ",");
+        writeNumber(writer, park->lon);
+        writeText(writer, ",");
+        writeCsvField(writer, counties);
+        writeText(writer, "\n");
+    }
+    else
+    {
+        writeText(writer, "{\"id\":");
+        writeInteger(writer, park->id, 0, true);
+        writeText(writer, ",\"name\":");
+        writeJsonString(writer, park->name);
+        writeText(writer, ",\"lat\":");
+        writeNumber(writer, park->lat);
+        writeText(writer, ",\"lon\":");
+        writeNumber(writer, park->lon);
+        writeText(writer, ",\"counties\":[");
+        for (int j = 0; j < countyCount; j++)
+        {
+            writeText(writer, j > 0 ? "," : "");
+            writeJsonString(writer, park->counties[j]);
+        }
+        writeText(writer, "]}\n");
+    }
+}
+
 /**
     This function prints all or some of the parks. It uses the function pointer parameter
     together with the string, str, which is passed to the function, to decide which parks to print.
     This function will be used for the list parks, list names, and list county commands.
+    Output goes through a fixed-size writer, so memory use does not grow with the catalog.
+    @param fp as the stream the parks are printed to.
     @param catalog as the catalog being printed.
     @param test as the helper method to help with making sure a park has the specific county
     @param str as a const pointer to the county.
+    @param format as the output format.
  */
-void listParks(Catalog *catalog, bool (*test)(Park const *park, char const *str), char const *str)
+void listParks(FILE *fp, Catalog *catalog, bool (*test)(Park const *park, char const *str), char const *str,
+               OutputFormat format)
 {
-    printf("%-3s %-40s %8s %8s Counties\n", "ID", "Name", "Lat", "Lon");
+    Writer *writer = (Writer *)allocate(MEM_OUTPUT, sizeof(Writer));
+    openWriter(writer, fp);
 
-    for (int i = 0; i < catalog->count; i++)
+    if (format == OUTPUT_BIN)
     {
-        Park *park = catalog->parks[i];
+        writeParkBlocks(writer, catalog, test, str);
+    }
+    else
+    {
+        if (format == OUTPUT_TEXT)
+        {
+            writePadded(writer, "ID", 3, true);
+            writeText(writer, " ");
+            writePadded(writer, "Name", MAX_NAME_LENGTH, true);
+            writeText(writer, " ");
+            writePadded(writer, "Lat", 8, false);
+            writeText(writer, " ");
+            writePadded(writer, "Lon", 8, false);
+            writeText(writer, " Counties\n");
+        }
+        else if (format == OUTPUT_CSV)
+        {
+            writeText(writer, "id,name,lat,lon,counties\n");
+        }
 
-        // Check if the park matches the test function
-        if (str == NULL || test(park, str))
+        for (int i = 0; i < catalog->count; i++)
         {
-            printf("%-3d %-40s %8.3f %8.3f", park->id, park->name, park->lat, park->lon);
+            Park *park = catalog->parks[i];
 
-            // Print counties
-            printf(" ");
-            for (int j = 0; j < MAX_COUNTIES; j++)
+            // Check if the park matches the test function
+            if (str == NULL || test(park, str))
             {
-                if (park->counties[j][0] == '\0')
-                {
-                    break;
-                }
-                printf("%s", park->counties[j]);
-                if (park->counties[j + 1][0] != '\0')
-                {
-                    printf(",");
-                }
+                writeParkRow(writer, park, format);
             }
-            printf("\n");
         }
     }
-}
\ No newline at end of file
+
+    flushWriter(writer);
+    release(writer);
+}
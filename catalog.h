@@ -13,6 +13,8 @@
 #define MAX_COUNTIES_NAME_LENGTH 12
 /** The max name length a park can have */
 #define MAX_NAME_LENGTH 40
+/** The number of cells along each side of the grid the Hilbert curve is drawn on */
+#define HILBERT_SIZE 65536
 
 /**
  * This is the struct for the park. It has 5 variable to it.
@@ -28,35 +30,67 @@ typedef struct Park
     char *name;                                            // Array for the park name
     double lat;                                            // Latitude
     double lon;                                            // Longitude
-    char counties[MAX_COUNTIES][MAX_COUNTIES_NAME_LENGTH]; // Double array of park county names
+    char counties[MAX_COUNTIES][MAX_COUNTIES_NAME_LENGTH + 1]; // Double array of park county names
 } Park;
 
 /**
- * This is the struct for the catalog. It has 3 variable to it.
- * @param parks as the list of parks
+ * This is the struct for the catalog. It has 9 variable to it. Once the catalog is
+ * indexed, the parks themselves live in one block ordered along a Hilbert curve, so parks
+ * that are close together on the map are close together in memory. The orders the
+ * commands list parks in are kept as separate arrays of pointers into that block.
+ * @param parks as the list of parks in the order they are currently listed in
  * @param count as the count of parks in the catalog
  * @param capacity as the max amount of parks in the catalog.
+ * @param generation as a counter that changes every time parks are loaded.
+ * @param store as the block of parks in Hilbert order, NULL until the catalog is indexed
+ * @param byFile as the list of parks in the order they were read
+ * @param byId as the list of parks sorted by ID
+ * @param byName as the list of parks sorted by name
+ * @param rank as the position of each park in store within the current list of parks
  */
 typedef struct Catalog
 {
     Park **parks;
     int count;
     int capacity;
+    unsigned long generation;
+    Park *store;
+    Park **byFile;
+    Park **byId;
+    Park **byName;
+    int *rank;
 } Catalog;
 
 /**
- * This is the struct for the trip. It has 3 variable to it.
+ * This is the struct for the trip. It has 4 variable to it.
  * @param parks as the list of parks
  * @param count as the count of parks in the trip
  * @param capacity as the max amount of parks in the trip.
+ * @param generation as a counter that changes every time a park is added or removed.
  */
 typedef struct Trip
 {
     Park **parks;
     int count;
     int capacity;
+    unsigned long generation;
 } Trip;
 
+/**
+ * This function computes the point on a unit sphere for a park's global coordinates.
+ * @param park as a pointer to a park.
+ * @param v as the array of 3 doubles the point is stored in.
+ */
+void unitVector(Park const *park, double v[]);
+
+/**
+ * This function turns the dot product of two unit vectors into the distance in miles
+ * between the points on the earth they stand for.
+ * @param dp as the dot product.
+ * @return the distance in miles.
+ */
+double arcDistance(double dp);
+
 /**
  * This returns the distance in miles between two parks. It computes this
  * distance based on the Parks’ global coordinates.
@@ -82,6 +116,17 @@ Catalog *makeCatalog();
  */
 void freeCatalog(Catalog *catalog);
 
+/**
+    This function parses the first line of a park record, which holds the ID, latitude,
+    longitude and counties separated by single spaces. It walks the line once, finding
+    each space with memchr() and converting each field where it sits.
+    @param line as the line being parsed
+    @param length as the number of characters in the line
+    @param park as the park the fields are stored in
+    @return true if the line is a valid park record.
+ */
+bool parseParkRecord(char const *line, size_t length, Park *park);
+
 /**
     This function reads all the parks from a park file with the given name.
     It makes an instance of the Park struct for each one and stores a pointer to that
@@ -91,6 +136,33 @@ void freeCatalog(Catalog *catalog);
  */
 void readParks(char const *filename, Catalog *catalog);
 
+/**
+    This function moves the parks into one block ordered along a Hilbert curve over their
+    latitude and longitude, and builds the lists of parks sorted by ID and by name. It is
+    called once after all park files are read, before any park is added to a trip.
+    @param catalog as the catalog being indexed
+    @param compareById as the compare method for sorting by ID
+    @param compareByName as the compare method for sorting by name
+ */
+void indexCatalog(Catalog *catalog, int (*compareById)(void const *va, void const *vb),
+                  int (*compareByName)(void const *va, void const *vb));
+
+/**
+    This function chooses which list of parks the catalog is listed in, without sorting.
+    @param catalog as the catalog
+    @param view as catalog->byFile, catalog->byId or catalog->byName
+ */
+void viewParks(Catalog *catalog, Park **view);
+
+/**
+    This function finds the park with the given ID by binary search over the parks sorted
+    by ID, so it must be called after indexCatalog().
+    @param catalog as the catalog
+    @param id as the ID of the park
+    @return the park, or NULL if there is no park with that ID.
+ */
+Park *findPark(Catalog const *catalog, int id);
+
 /**
     This function sorts the parks in the given catalog. It uses the qsort() function
     together with the function pointer parameter to order the parks.
@@ -103,8 +175,12 @@ void sortParks(Catalog *catalog, int (*compare)(void const *va, void const *vb))
     This function prints all or some of the parks. It uses the function pointer parameter
     together with the string, str, which is passed to the function, to decide which parks to print.
     This function will be used for the list parks, list names, and list county commands.
+    Output goes through a fixed-size writer, so memory use does not grow with the catalog.
+    @param fp as the stream the parks are printed to.
     @param catalog as the catalog being printed.
     @param test as the helper method to help with making sure a park has the specific county
     @param str as a const pointer to the county.
+    @param format as the output format.
  */
-void listParks(Catalog *catalog, bool (*test)(Park const *park, char const *str), char const *str);
\ No newline at end of file
+void listParks(FILE *fp, Catalog *catalog, bool (*test)(Park const *park, char const *str), char const *str,
+               OutputFormat format);
\ No newline at end of file
@@ -0,0 +1,44 @@
+/**
+    @file hash.c
+    @author Samuel E McConnell (semcconn)
+    The hash component has the FNV-1a hash used for the cache buckets, the county table in
+    binary output and the journal checksums. It is quick on short keys and spreads them
+    well enough for tables indexed by its low bits.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hash.h"
+
+/** The FNV-1a multiplier for 32-bit hashes */
+#define HASH_PRIME 16777619U
+
+/**
+    This function adds some bytes to an FNV-1a hash. Hashes of several blocks are made by
+    passing the result for one block as the starting hash for the next.
+    @param bytes as the bytes being hashed
+    @param length as the number of bytes
+    @param hash as the hash so far, HASH_START for a new hash
+    @return the hash.
+ */
+uint32_t hashBytes(void const *bytes, size_t length, uint32_t hash)
+{
+    unsigned char const *p = (unsigned char const *)bytes;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= p[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+/**
+    This function hashes a string with the FNV-1a hash.
+    @param str as the string being hashed
+    @return the hash.
+ */
+uint32_t hashString(char const *str)
+{
+    return hashBytes(str, strlen(str), HASH_START);
+}
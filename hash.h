@@ -0,0 +1,26 @@
+/**
+    @file hash.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for hash.c. This file lets the other components hash strings
+    and blocks of bytes with the same FNV-1a hash.
+*/
+
+/** The value an FNV-1a hash starts from */
+#define HASH_START 2166136261U
+
+/**
+    This function adds some bytes to an FNV-1a hash. Hashes of several blocks are made by
+    passing the result for one block as the starting hash for the next.
+    @param bytes as the bytes being hashed
+    @param length as the number of bytes
+    @param hash as the hash so far, HASH_START for a new hash
+    @return the hash.
+ */
+uint32_t hashBytes(void const *bytes, size_t length, uint32_t hash);
+
+/**
+    This function hashes a string with the FNV-1a hash.
+    @param str as the string being hashed
+    @return the hash.
+ */
+uint32_t hashString(char const *str);
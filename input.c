@@ -1,13 +1,19 @@
 /**
     @file input.c
     @author Samuel E McConnell (semcconn)
-    This file has one function. This file is used to read a line from the file and return it.
-    This file is used by other functions to read the files needed to make the prgram run.
+    This file is used to read a line from the file and return it. This file is used by other
+    functions to read the files needed to make the prgram run. The line reader reads big
+    blocks with read() and finds the ends of lines with memchr(), for the park files and
+    commands, where reading a character at a time and allocating every line was slow.
 */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
 #include "input.h"
+#include "alloc.h"
 
 /** This is the initial buffer size for the line */
 #define INITIAL_BUFFEER_SIZE 50
@@ -26,16 +32,10 @@
 char *readLine(FILE *fp)
 {
     int size = INITIAL_BUFFEER_SIZE;
-    char *line = (char *)malloc(size * sizeof(line));
-
-    if (line == NULL)
-    {
-        fprintf(stderr, "some error");
-        exit(EXIT_FAILURE);
-    }
+    char *line = (char *)allocate(MEM_IO, size * sizeof(char));
 
     int position = 0;
-    char c;
+    int c;
 
     while (1)
     {
@@ -54,14 +54,128 @@ char *readLine(FILE *fp)
         if (position >= size)
         {
             size *= 2;
-            line = (char *)realloc(line, size * sizeof(char));
+            line = (char *)reallocate(MEM_IO, line, size * sizeof(char));
         }
     }
     if (position == 0 && c == EOF)
     {
-        free(line);
+        release(line);
         return NULL;
     }
 
     return line;
-}
\ No newline at end of file
+}
+/**
+    This function makes a line reader for a file descriptor. The caller still owns the
+    file descriptor and closes it after the reader is freed.
+    @param fd as the file descriptor to read
+    @return the line reader.
+*/
+LineReader *makeLineReader(int fd)
+{
+    LineReader *reader = (LineReader *)allocate(MEM_IO, sizeof(LineReader));
+    reader->fd = fd;
+    reader->size = LINE_READER_BUFFER_SIZE;
+    reader->buffer = (char *)allocate(MEM_IO, reader->size);
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = false;
+    return reader;
+}
+
+/**
+    This function frees a line reader and its buffer.
+    @param reader as the line reader being freed
+*/
+void freeLineReader(LineReader *reader)
+{
+    release(reader->buffer);
+    release(reader);
+}
+
+/**
+    This function makes room at the end of the buffer. The part of a line not handed out
+    yet is moved to the front, and the buffer is doubled if that line fills it.
+    @param reader as the line reader
+*/
+static void makeRoom(LineReader *reader)
+{
+    if (reader->start > 0)
+    {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->size)
+    {
+        reader->size *= 2;
+        reader->buffer = (char *)reallocate(MEM_IO, reader->buffer, reader->size);
+    }
+}
+
+/**
+    This function reads more of the file into the buffer.
+    @param reader as the line reader
+*/
+static void fillLineReader(LineReader *reader)
+{
+    makeRoom(reader);
+    ssize_t count;
+    do
+    {
+        count = read(reader->fd, reader->buffer + reader->end, reader->size - reader->end);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0)
+    {
+        reader->eof = true;
+        return;
+    }
+    reader->end += count;
+}
+
+/**
+    This function returns the next line from a line reader, without its newline. The line
+    is part of the reader's buffer, so it is only good until the next call.
+    @param reader as the line reader
+    @param length as where the number of characters in the line is stored
+    @return the line, or NULL if there is no more input.
+*/
+char *nextLine(LineReader *reader, size_t *length)
+{
+    // Only the bytes read since the last search are searched again
+    size_t searched = reader->start;
+    while (1)
+    {
+        char *newline = (char *)memchr(reader->buffer + searched, '\n', reader->end - searched);
+        if (newline != NULL)
+        {
+            char *line = reader->buffer + reader->start;
+            *newline = '\0';
+            *length = newline - line;
+            reader->start = newline + 1 - reader->buffer;
+            return line;
+        }
+        if (reader->eof)
+        {
+            break;
+        }
+        searched = reader->end - reader->start;
+        fillLineReader(reader);
+        searched += reader->start;
+    }
+
+    if (reader->start == reader->end)
+    {
+        return NULL;
+    }
+    // The last line has no newline, so room is made for its terminator
+    if (reader->end == reader->size)
+    {
+        makeRoom(reader);
+    }
+    char *line = reader->buffer + reader->start;
+    *length = reader->end - reader->start;
+    line[*length] = '\0';
+    reader->start = reader->end;
+    return line;
+}
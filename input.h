@@ -7,6 +7,29 @@
 
 /** This is the initial buffer size for the line */
 #define INITIAL_BUFFEER_SIZE 50
+/** This is the number of bytes a line reader asks for with each read */
+#define LINE_READER_BUFFER_SIZE 65536
+
+/**
+ * This is the struct for a line reader. It reads a file in large blocks into one buffer
+ * and hands out lines where they sit in the buffer, so reading a line does not allocate
+ * memory. The buffer only grows when a single line does not fit in it.
+ * @param fd as the file descriptor being read
+ * @param buffer as the bytes read from the file
+ * @param size as the number of bytes the buffer can hold
+ * @param start as the position of the first byte not handed out yet
+ * @param end as the position after the last byte read
+ * @param eof as true once the end of the file was reached
+ */
+typedef struct LineReader
+{
+    int fd;
+    char *buffer;
+    size_t size;
+    size_t start;
+    size_t end;
+    bool eof;
+} LineReader;
 
 /**
     This function reads a single line of input from the given input stream (stdin or a file) and returns
@@ -20,3 +43,26 @@
     @return a pointer to a char string as the line it read from the file
 */
 char *readLine(FILE *fp);
+
+/**
+    This function makes a line reader for a file descriptor. The caller still owns the
+    file descriptor and closes it after the reader is freed.
+    @param fd as the file descriptor to read
+    @return the line reader.
+*/
+LineReader *makeLineReader(int fd);
+
+/**
+    This function frees a line reader and its buffer.
+    @param reader as the line reader being freed
+*/
+void freeLineReader(LineReader *reader);
+
+/**
+    This function returns the next line from a line reader, without its newline. The line
+    is part of the reader's buffer, so it is only good until the next call.
+    @param reader as the line reader
+    @param length as where the number of characters in the line is stored
+    @return the line, or NULL if there is no more input.
+*/
+char *nextLine(LineReader *reader, size_t *length);
@@ -0,0 +1,491 @@
+/**
+    @file journal.c
+    @author Samuel E McConnell (semcconn)
+    The journal component keeps the trip on disk. Each change is appended to the journal
+    file as a small fixed-size record, which is much cheaper than writing the whole trip
+    after every command, and the records are flushed to the disk in batches. Now and then
+    the whole trip is written to a snapshot and the journal starts again empty, so
+    rebuilding the trip never has to read more than the changes since the last snapshot.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "output.h"
+#include "catalog.h"
+#include "journal.h"
+#include "alloc.h"
+#include "hash.h"
+
+/**
+ * This is the struct for the start of the journal file.
+ * @param magic as JOURNAL_MAGIC
+ * @param version as JOURNAL_VERSION
+ * @param epoch as the epoch of the snapshot the changes follow
+ */
+typedef struct JournalHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t epoch;
+} JournalHeader;
+
+/**
+ * This is the struct for one change in the journal file.
+ * @param op as the kind of change
+ * @param id as the ID of the park that changed
+ * @param position as the position the park was moved to, for JOURNAL_MOVE
+ * @param check as the checksum of the other fields
+ */
+typedef struct JournalRecord
+{
+    uint32_t op;
+    int32_t id;
+    int32_t position;
+    uint32_t check;
+} JournalRecord;
+
+/**
+ * This is the struct for the start of the snapshot file.
+ * @param magic as SNAPSHOT_MAGIC
+ * @param version as JOURNAL_VERSION
+ * @param epoch as the epoch of the snapshot
+ * @param count as the number of parks in the trip
+ * @param check as the checksum of the park IDs that follow
+ */
+typedef struct SnapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t epoch;
+    uint32_t count;
+    uint32_t check;
+} SnapshotHeader;
+
+/**
+    This function computes the FNV-1a hash of some bytes, starting from a seed so records
+    left over from an older epoch do not check out.
+    @param bytes as the bytes being hashed
+    @param length as the number of bytes
+    @param seed as the value mixed in first
+    @return the checksum.
+ */
+static uint32_t checksum(void const *bytes, size_t length, uint64_t seed)
+{
+    unsigned char seedBytes[8];
+    for (int i = 0; i < 8; i++)
+    {
+        seedBytes[i] = (seed >> (8 * i)) & 0xFF;
+    }
+    return hashBytes(bytes, length, hashBytes(seedBytes, sizeof(seedBytes), HASH_START));
+}
+
+/**
+    This function prints an error about a journal file and exits.
+    @param message as the kind of error
+    @param filename as the name of the file
+ */
+static void journalError(char const *message, char const *filename)
+{
+    fprintf(stderr, "%s: %s\n", message, filename);
+    exit(EXIT_FAILURE);
+}
+
+/**
+    This function finds the position of the first visit to a park in the trip.
+    @param trip as the trip
+    @param id as the ID of the park
+    @return the position, or -1 if the park is not in the trip.
+ */
+static int tripIndex(Trip const *trip, int id)
+{
+    for (int i = 0; i < trip->count; i++)
+    {
+        if (trip->parks[i]->id == id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+    This function applies one change to the trip. Changes to parks that are not in the
+    catalog or the trip are skipped.
+    @param catalog as the catalog
+    @param trip as the trip
+    @param op as the kind of change
+    @param id as the ID of the park that changed
+    @param position as the position the park was moved to, for JOURNAL_MOVE
+ */
+static void applyChange(Catalog const *catalog, Trip *trip, int op, int id, int position)
+{
+    if (op == JOURNAL_ADD)
+    {
+        Park *park = findPark(catalog, id);
+        if (park == NULL)
+        {
+            return;
+        }
+        if (trip->count == trip->capacity)
+        {
+            trip->capacity *= 2;
+            trip->parks = (Park **)reallocate(MEM_TRIP, trip->parks, sizeof(Park *) * trip->capacity);
+        }
+        trip->parks[trip->count++] = park;
+        trip->generation++;
+        return;
+    }
+
+    int index = tripIndex(trip, id);
+    if (index < 0)
+    {
+        return;
+    }
+    Park *park = trip->parks[index];
+    if (op == JOURNAL_REMOVE)
+    {
+        memmove(trip->parks + index, trip->parks + index + 1, sizeof(Park *) * (trip->count - index - 1));
+        trip->count--;
+    }
+    else
+    {
+        position = position < 0 ? 0 : (position >= trip->count ? trip->count - 1 : position);
+        if (position < index)
+        {
+            memmove(trip->parks + position + 1, trip->parks + position, sizeof(Park *) * (index - position));
+        }
+        else
+        {
+            memmove(trip->parks + index, trip->parks + index + 1, sizeof(Park *) * (position - index));
+        }
+        trip->parks[position] = park;
+    }
+    trip->generation++;
+}
+
+/**
+    This function writes all of a block of bytes to a file, or exits if it can't.
+    @param fd as the file descriptor
+    @param bytes as the bytes being written
+    @param length as the number of bytes
+    @param filename as the name of the file, for the error message
+ */
+static void writeAll(int fd, void const *bytes, size_t length, char const *filename)
+{
+    char const *p = (char const *)bytes;
+    while (length > 0)
+    {
+        ssize_t written = write(fd, p, length);
+        if (written <= 0)
+        {
+            journalError("Can't write file", filename);
+        }
+        p += written;
+        length -= written;
+    }
+}
+
+/**
+    This function flushes the directory holding a file to the disk, so a rename into it
+    is not lost if the power goes.
+    @param filename as the name of the file
+ */
+static void syncDirectory(char const *filename)
+{
+    char const *slash = strrchr(filename, '/');
+    size_t length = slash == NULL ? 1 : (slash == filename ? 1 : (size_t)(slash - filename));
+    char *directory = (char *)allocate(MEM_QUERY, length + 1);
+    memcpy(directory, slash == NULL ? "." : filename, length);
+    directory[length] = '\0';
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd < 0 || fsync(fd) != 0)
+    {
+        journalError("Can't write file", directory);
+    }
+    close(fd);
+    release(directory);
+}
+
+/**
+    This function empties the journal file and writes its header for the current epoch.
+    @param journal as the journal
+ */
+static void resetJournal(Journal *journal)
+{
+    JournalHeader header;
+    memcpy(header.magic, JOURNAL_MAGIC, 4);
+    header.version = JOURNAL_VERSION;
+    header.epoch = journal->epoch;
+    if (ftruncate(journal->fd, 0) != 0 || lseek(journal->fd, 0, SEEK_SET) != 0)
+    {
+        journalError("Can't write file", journal->filename);
+    }
+    writeAll(journal->fd, &header, sizeof(header), journal->filename);
+    if (fdatasync(journal->fd) != 0)
+    {
+        journalError("Can't write file", journal->filename);
+    }
+    journal->unsynced = 0;
+    journal->records = 0;
+}
+
+/**
+    This function maps a whole file into memory to be read.
+    @param fd as the file descriptor
+    @param size as where the size of the file is stored
+    @param filename as the name of the file, for the error message
+    @return the mapped file, or NULL if the file is empty.
+ */
+static void *mapFile(int fd, size_t *size, char const *filename)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        journalError("Can't open file", filename);
+    }
+    *size = st.st_size;
+    if (*size == 0)
+    {
+        return NULL;
+    }
+    void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        journalError("Can't open file", filename);
+    }
+    return map;
+}
+
+/**
+    This function adds the parks in the snapshot to the trip.
+    @param journal as the journal, whose epoch is set to the snapshot's
+    @param catalog as the catalog
+    @param trip as the trip
+ */
+static void readSnapshot(Journal *journal, Catalog const *catalog, Trip *trip)
+{
+    int fd = open(journal->snapshotName, O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    size_t size;
+    char const *map = (char const *)mapFile(fd, &size, journal->snapshotName);
+    close(fd);
+
+    SnapshotHeader header;
+    if (size < sizeof(header))
+    {
+        journalError("Invalid journal file", journal->snapshotName);
+    }
+    memcpy(&header, map, sizeof(header));
+    int32_t const *ids = (int32_t const *)(map + sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != JOURNAL_VERSION ||
+        size != sizeof(header) + sizeof(int32_t) * (size_t)header.count ||
+        header.check != checksum(ids, sizeof(int32_t) * header.count, header.epoch))
+    {
+        journalError("Invalid journal file", journal->snapshotName);
+    }
+
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        applyChange(catalog, trip, JOURNAL_ADD, ids[i], 0);
+    }
+    journal->epoch = header.epoch;
+    munmap((void *)map, size);
+}
+
+/**
+    This function applies the changes in the journal file to the trip, and cuts off a
+    change that was only partly written. A journal left over from before the last snapshot
+    is emptied instead.
+    @param journal as the journal
+    @param catalog as the catalog
+    @param trip as the trip
+ */
+static void replayJournal(Journal *journal, Catalog const *catalog, Trip *trip)
+{
+    size_t size;
+    char const *map = (char const *)mapFile(journal->fd, &size, journal->filename);
+
+    JournalHeader header;
+    if (size < sizeof(header))
+    {
+        // The header itself was never finished, so there are no changes to keep
+        if (map != NULL)
+        {
+            munmap((void *)map, size);
+        }
+        resetJournal(journal);
+        return;
+    }
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, JOURNAL_MAGIC, 4) != 0 || header.version != JOURNAL_VERSION ||
+        header.epoch > journal->epoch)
+    {
+        journalError("Invalid journal file", journal->filename);
+    }
+    if (header.epoch < journal->epoch)
+    {
+        // The program stopped after writing a snapshot but before emptying the journal
+        munmap((void *)map, size);
+        resetJournal(journal);
+        return;
+    }
+
+    size_t end = sizeof(header);
+    JournalRecord record;
+    while (end + sizeof(record) <= size)
+    {
+        memcpy(&record, map + end, sizeof(record));
+        if (record.check != checksum(&record, offsetof(JournalRecord, check), journal->epoch))
+        {
+            break;
+        }
+        applyChange(catalog, trip, record.op, record.id, record.position);
+        journal->records++;
+        end += sizeof(record);
+    }
+    munmap((void *)map, size);
+
+    if ((end < size && ftruncate(journal->fd, end) != 0) || lseek(journal->fd, end, SEEK_SET) < 0)
+    {
+        journalError("Can't write file", journal->filename);
+    }
+}
+
+/**
+    This function opens a journal and rebuilds the trip it holds. The snapshot is mapped
+    into memory and its parks added to the trip, then the changes in the journal are
+    applied, so the time taken depends on the changes made since the last snapshot. A
+    change that was only partly written when the program stopped is dropped. Parks that
+    are no longer in the catalog are skipped. The files are made if they do not exist.
+    @param filename as the name of the journal file
+    @param catalog as the catalog, which must already be indexed
+    @param trip as the empty trip that is rebuilt
+    @return the open journal.
+ */
+Journal *openJournal(char const *filename, Catalog const *catalog, Trip *trip)
+{
+    Journal *journal = (Journal *)allocate(MEM_TRIP, sizeof(Journal));
+    journal->filename = (char *)allocate(MEM_TRIP, strlen(filename) + 1);
+    strcpy(journal->filename, filename);
+    journal->snapshotName = (char *)allocate(MEM_TRIP, strlen(filename) + strlen(SNAPSHOT_SUFFIX) + 1);
+    strcpy(journal->snapshotName, filename);
+    strcat(journal->snapshotName, SNAPSHOT_SUFFIX);
+    journal->epoch = 0;
+    journal->unsynced = 0;
+    journal->records = 0;
+
+    journal->fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (journal->fd < 0)
+    {
+        journalError("Can't open file", filename);
+    }
+    readSnapshot(journal, catalog, trip);
+    replayJournal(journal, catalog, trip);
+    return journal;
+}
+
+/**
+    This function adds a change to the end of the journal. Changes are flushed to the disk
+    in batches, and folded into a new snapshot once enough of them build up.
+    @param journal as the journal
+    @param trip as the trip after the change
+    @param op as the kind of change
+    @param id as the ID of the park that changed
+    @param position as the position the park was moved to, for JOURNAL_MOVE
+ */
+void journalChange(Journal *journal, Trip const *trip, JournalOp op, int id, int position)
+{
+    JournalRecord record;
+    record.op = op;
+    record.id = id;
+    record.position = position;
+    record.check = checksum(&record, offsetof(JournalRecord, check), journal->epoch);
+    writeAll(journal->fd, &record, sizeof(record), journal->filename);
+    journal->records++;
+
+    if (++journal->unsynced >= JOURNAL_SYNC_RECORDS)
+    {
+        if (fdatasync(journal->fd) != 0)
+        {
+            journalError("Can't write file", journal->filename);
+        }
+        journal->unsynced = 0;
+    }
+    if (journal->records >= JOURNAL_COMPACT_RECORDS)
+    {
+        compactJournal(journal, trip);
+    }
+}
+
+/**
+    This function writes the whole trip to a new snapshot and empties the journal. The
+    snapshot is written to a temporary file and renamed over the old one, so a crash at
+    any point leaves either the old snapshot and journal or the new ones.
+    @param journal as the journal
+    @param trip as the trip
+ */
+void compactJournal(Journal *journal, Trip const *trip)
+{
+    int32_t *ids = (int32_t *)allocate(MEM_QUERY, sizeof(int32_t) * (trip->count + 1));
+    for (int i = 0; i < trip->count; i++)
+    {
+        ids[i] = trip->parks[i]->id;
+    }
+
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+    header.version = JOURNAL_VERSION;
+    header.epoch = journal->epoch + 1;
+    header.count = trip->count;
+    header.check = checksum(ids, sizeof(int32_t) * trip->count, header.epoch);
+
+    char *tempName = (char *)allocate(MEM_QUERY, strlen(journal->snapshotName) + strlen(".tmp") + 1);
+    strcpy(tempName, journal->snapshotName);
+    strcat(tempName, ".tmp");
+    int fd = open(tempName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        journalError("Can't open file", tempName);
+    }
+    writeAll(fd, &header, sizeof(header), tempName);
+    writeAll(fd, ids, sizeof(int32_t) * trip->count, tempName);
+    if (fsync(fd) != 0 || close(fd) != 0 || rename(tempName, journal->snapshotName) != 0)
+    {
+        journalError("Can't write file", journal->snapshotName);
+    }
+    release(tempName);
+    release(ids);
+    syncDirectory(journal->snapshotName);
+
+    // Only once the new snapshot is in place can the changes it holds be thrown away
+    journal->epoch = header.epoch;
+    resetJournal(journal);
+}
+
+/**
+    This function folds the journal into a snapshot, closes it and frees its memory.
+    @param journal as the journal
+    @param trip as the trip
+ */
+void closeJournal(Journal *journal, Trip const *trip)
+{
+    if (journal->records > 0)
+    {
+        compactJournal(journal, trip);
+    }
+    close(journal->fd);
+    release(journal->filename);
+    release(journal->snapshotName);
+    release(journal);
+}
@@ -0,0 +1,98 @@
+/**
+    @file journal.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for journal.c. This file lets the trip be kept on disk, so it
+    is rebuilt when the program starts again instead of being lost.
+*/
+
+/** The 4 bytes a journal file starts with */
+#define JOURNAL_MAGIC "NCTJ"
+/** The 4 bytes a snapshot file starts with */
+#define SNAPSHOT_MAGIC "NCTS"
+/** The version of the journal and snapshot formats */
+#define JOURNAL_VERSION 1
+/** The number of changes written between each flush to the disk */
+#define JOURNAL_SYNC_RECORDS 32
+/** The number of changes in the journal before they are folded into a new snapshot */
+#define JOURNAL_COMPACT_RECORDS 4096
+/** What is added to the journal file name to name its snapshot file */
+#define SNAPSHOT_SUFFIX ".snap"
+
+/**
+ * These are the kinds of change to a trip the journal records.
+ *
+ * The journal file starts with the 4 magic bytes, the version as a 32-bit integer and the
+ * epoch as a 64-bit integer, then has one 16-byte record per change: the kind of change,
+ * the park ID and the position as 32-bit integers, and a checksum of the other 12 bytes
+ * seeded with the epoch. The snapshot file starts with its own magic bytes, the version,
+ * the epoch, the number of parks and a checksum of the park IDs, then has the IDs of the
+ * parks in the trip as 32-bit integers. Everything is in the machine's byte order.
+ *
+ * A journal only holds the changes made after the snapshot with the same epoch, so a
+ * journal with an older epoch than the snapshot has already been folded into it.
+ */
+typedef enum JournalOp
+{
+    JOURNAL_ADD = 1, // The park was added to the end of the trip
+    JOURNAL_REMOVE,  // The first visit to the park was removed from the trip
+    JOURNAL_MOVE     // The first visit to the park was moved to the position
+} JournalOp;
+
+/**
+ * This is the struct for an open journal.
+ * @param fd as the file descriptor of the journal file, positioned at its end
+ * @param filename as the name of the journal file
+ * @param snapshotName as the name of the snapshot file
+ * @param epoch as the epoch of the current snapshot and journal
+ * @param unsynced as the number of changes written since the last flush to the disk
+ * @param records as the number of changes in the journal file
+ */
+typedef struct Journal
+{
+    int fd;
+    char *filename;
+    char *snapshotName;
+    unsigned long long epoch;
+    int unsynced;
+    int records;
+} Journal;
+
+/**
+    This function opens a journal and rebuilds the trip it holds. The snapshot is mapped
+    into memory and its parks added to the trip, then the changes in the journal are
+    applied, so the time taken depends on the changes made since the last snapshot. A
+    change that was only partly written when the program stopped is dropped. Parks that
+    are no longer in the catalog are skipped. The files are made if they do not exist.
+    @param filename as the name of the journal file
+    @param catalog as the catalog, which must already be indexed
+    @param trip as the empty trip that is rebuilt
+    @return the open journal.
+ */
+Journal *openJournal(char const *filename, Catalog const *catalog, Trip *trip);
+
+/**
+    This function adds a change to the end of the journal. Changes are flushed to the disk
+    in batches, and folded into a new snapshot once enough of them build up.
+    @param journal as the journal
+    @param trip as the trip after the change
+    @param op as the kind of change
+    @param id as the ID of the park that changed
+    @param position as the position the park was moved to, for JOURNAL_MOVE
+ */
+void journalChange(Journal *journal, Trip const *trip, JournalOp op, int id, int position);
+
+/**
+    This function writes the whole trip to a new snapshot and empties the journal. The
+    snapshot is written to a temporary file and renamed over the old one, so a crash at
+    any point leaves either the old snapshot and journal or the new ones.
+    @param journal as the journal
+    @param trip as the trip
+ */
+void compactJournal(Journal *journal, Trip const *trip);
+
+/**
+    This function folds the journal into a snapshot, closes it and frees its memory.
+    @param journal as the journal
+    @param trip as the trip
+ */
+void closeJournal(Journal *journal, Trip const *trip);
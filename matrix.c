@@ -0,0 +1,246 @@
+/**
+    @file matrix.c
+    @author Samuel E McConnell (semcconn)
+    The matrix component computes the distance between every pair of parks in a trip. Each
+    park's unit vector is computed once and kept in three separate arrays, so the inner loop
+    over a tile is a plain multiply and add over contiguous memory that the compiler can
+    vectorise. Only the tiles on and above the diagonal are computed, since the distance
+    from a to b is exactly the distance from b to a, and the rows of tiles are shared out
+    between threads.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "output.h"
+#include "catalog.h"
+#include "matrix.h"
+#include "alloc.h"
+
+/**
+ * This is the struct for the work given to one thread.
+ * @param x as the first coordinate of each park's unit vector
+ * @param y as the second coordinate of each park's unit vector
+ * @param z as the third coordinate of each park's unit vector
+ * @param count as the number of parks
+ * @param matrix as the matrix being filled in
+ * @param first as the first row of tiles this thread computes
+ * @param step as the number of rows of tiles between the ones this thread computes
+ */
+typedef struct MatrixWork
+{
+    double const *x;
+    double const *y;
+    double const *z;
+    int count;
+    double *matrix;
+    int first;
+    int step;
+} MatrixWork;
+
+/**
+    This function computes one tile of the matrix and mirrors it below the diagonal.
+    @param work as the vectors and the matrix
+    @param rowStart as the first row of the tile
+    @param columnStart as the first column of the tile
+ */
+static void computeTile(MatrixWork const *work, int rowStart, int columnStart)
+{
+    int count = work->count;
+    int rowEnd = rowStart + MATRIX_TILE < count ? rowStart + MATRIX_TILE : count;
+    int columnEnd = columnStart + MATRIX_TILE < count ? columnStart + MATRIX_TILE : count;
+    double dp[MATRIX_TILE];
+
+    for (int i = rowStart; i < rowEnd; i++)
+    {
+        double xi = work->x[i];
+        double yi = work->y[i];
+        double zi = work->z[i];
+        int from = (rowStart == columnStart) ? i : columnStart;
+
+        // Summed in the same order as distance(), so the results match it exactly
+        for (int j = from; j < columnEnd; j++)
+        {
+            dp[j - columnStart] = xi * work->x[j] + yi * work->y[j] + zi * work->z[j];
+        }
+
+        double *row = work->matrix + (size_t)i * count;
+        for (int j = from; j < columnEnd; j++)
+        {
+            double dist = arcDistance(dp[j - columnStart]);
+            row[j] = dist;
+            work->matrix[(size_t)j * count + i] = dist;
+        }
+    }
+}
+
+/**
+    This function computes every tile in the rows of tiles given to a thread.
+    @param arg as the MatrixWork for the thread
+    @return NULL.
+ */
+static void *computeRows(void *arg)
+{
+    MatrixWork const *work = (MatrixWork const *)arg;
+    int tiles = (work->count + MATRIX_TILE - 1) / MATRIX_TILE;
+    for (int t = work->first; t < tiles; t += work->step)
+    {
+        for (int u = t; u < tiles; u++)
+        {
+            computeTile(work, t * MATRIX_TILE, u * MATRIX_TILE);
+        }
+    }
+    return NULL;
+}
+
+/**
+    This function computes the distance in miles between every pair of the given parks.
+    The matrix is split into square tiles that are shared out between threads.
+    @param parks as the list of parks
+    @param count as the number of parks
+    @return the count by count matrix, row by row, allocated with allocate().
+ */
+double *distanceMatrix(Park **parks, int count)
+{
+    double *matrix = (double *)allocate(MEM_QUERY, sizeof(double) * count * count);
+    double *vectors = (double *)allocate(MEM_QUERY, sizeof(double) * count * 3);
+    double *x = vectors;
+    double *y = vectors + count;
+    double *z = vectors + 2 * count;
+    for (int i = 0; i < count; i++)
+    {
+        double v[3];
+        unitVector(parks[i], v);
+        x[i] = v[0];
+        y[i] = v[1];
+        z[i] = v[2];
+    }
+
+    // Rows of tiles are dealt out in turn, so each thread gets long and short rows
+    int tiles = (count + MATRIX_TILE - 1) / MATRIX_TILE;
+    int threads = 1;
+    if (count >= MATRIX_THREAD_THRESHOLD)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > MATRIX_MAX_THREADS ? MATRIX_MAX_THREADS : (cpus > 1 ? (int)cpus : 1);
+        threads = threads > tiles ? tiles : threads;
+    }
+
+    MatrixWork work[MATRIX_MAX_THREADS];
+    pthread_t ids[MATRIX_MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        work[t].x = x;
+        work[t].y = y;
+        work[t].z = z;
+        work[t].count = count;
+        work[t].matrix = matrix;
+        work[t].first = t;
+        work[t].step = threads;
+    }
+    for (int t = 1; t < threads; t++)
+    {
+        if (pthread_create(&ids[t], NULL, computeRows, &work[t]) != 0)
+        {
+            break;
+        }
+        started++;
+    }
+    if (started < threads - 1)
+    {
+        // Not every thread could start, so this thread computes the rows left over
+        for (int t = started + 1; t < threads; t++)
+        {
+            computeRows(&work[t]);
+        }
+    }
+    computeRows(&work[0]);
+    for (int t = 1; t <= started; t++)
+    {
+        pthread_join(ids[t], NULL);
+    }
+
+    release(vectors);
+    return matrix;
+}
+
+/**
+    This function prints a distance matrix as a table with a row and a column for each park.
+    @param fp as the stream the table is printed to
+    @param parks as the list of parks
+    @param count as the number of parks
+    @param matrix as the matrix returned by distanceMatrix()
+ */
+void printMatrix(FILE *fp, Park **parks, int count, double const *matrix)
+{
+    Writer *writer = (Writer *)allocate(MEM_OUTPUT, sizeof(Writer));
+    openWriter(writer, fp);
+    writePadded(writer, "ID", 3, true);
+    for (int j = 0; j < count; j++)
+    {
+        writeText(writer, " ");
+        writeInteger(writer, parks[j]->id, 8, false);
+    }
+    writeText(writer, "\n");
+
+    for (int i = 0; i < count; i++)
+    {
+        writeInteger(writer, parks[i]->id, 3, true);
+        for (int j = 0; j < count; j++)
+        {
+            writeText(writer, " ");
+            writeFixed(writer, matrix[(size_t)i * count + j], 8, 1);
+        }
+        writeText(writer, "\n");
+    }
+    flushWriter(writer);
+    release(writer);
+}
+
+/**
+    This function writes a distance matrix to a file in a compact binary form: the magic
+    bytes, the number of parks as a 32-bit integer, the park IDs as 32-bit integers and
+    then the distances as 32-bit floats, row by row, all in the machine's byte order.
+    @param filename as the name of the file being written
+    @param parks as the list of parks
+    @param count as the number of parks
+    @param matrix as the matrix returned by distanceMatrix()
+    @return true if the whole file was written.
+ */
+bool writeMatrix(char const *filename, Park **parks, int count, double const *matrix)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+
+    bool ok = fwrite(MATRIX_MAGIC, 1, 4, fp) == 4;
+    int32_t header = count;
+    ok = ok && fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    int32_t *ids = (int32_t *)allocate(MEM_QUERY, sizeof(int32_t) * count);
+    for (int i = 0; i < count; i++)
+    {
+        ids[i] = parks[i]->id;
+    }
+    ok = ok && fwrite(ids, sizeof(int32_t), count, fp) == (size_t)count;
+    release(ids);
+
+    float *row = (float *)allocate(MEM_QUERY, sizeof(float) * count);
+    for (int i = 0; i < count && ok; i++)
+    {
+        for (int j = 0; j < count; j++)
+        {
+            row[j] = (float)matrix[(size_t)i * count + j];
+        }
+        ok = fwrite(row, sizeof(float), count, fp) == (size_t)count;
+    }
+    release(row);
+
+    return fclose(fp) == 0 && ok;
+}
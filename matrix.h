@@ -0,0 +1,45 @@
+/**
+    @file matrix.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for matrix.c. This file lets the other components compute and
+    print the table of distances between every pair of parks in a trip.
+*/
+
+/** The number of rows and columns of the matrix computed together */
+#define MATRIX_TILE 64
+/** The most threads used to compute a matrix */
+#define MATRIX_MAX_THREADS 16
+/** Matrices with fewer parks than this are computed without starting threads */
+#define MATRIX_THREAD_THRESHOLD 256
+/** The 4 bytes a binary matrix file starts with */
+#define MATRIX_MAGIC "NCDM"
+
+/**
+    This function computes the distance in miles between every pair of the given parks.
+    The matrix is split into square tiles that are shared out between threads.
+    @param parks as the list of parks
+    @param count as the number of parks
+    @return the count by count matrix, row by row, allocated with allocate().
+ */
+double *distanceMatrix(Park **parks, int count);
+
+/**
+    This function prints a distance matrix as a table with a row and a column for each park.
+    @param fp as the stream the table is printed to
+    @param parks as the list of parks
+    @param count as the number of parks
+    @param matrix as the matrix returned by distanceMatrix()
+ */
+void printMatrix(FILE *fp, Park **parks, int count, double const *matrix);
+
+/**
+    This function writes a distance matrix to a file in a compact binary form: the magic
+    bytes, the number of parks as a 32-bit integer, the park IDs as 32-bit integers and
+    then the distances as 32-bit floats, row by row, all in the machine's byte order.
+    @param filename as the name of the file being written
+    @param parks as the list of parks
+    @param count as the number of parks
+    @param matrix as the matrix returned by distanceMatrix()
+    @return true if the whole file was written.
+ */
+bool writeMatrix(char const *filename, Park **parks, int count, double const *matrix);
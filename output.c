@@ -0,0 +1,328 @@
+/**
+    @file output.c
+    @author Samuel E McConnell (semcconn)
+    The output component writes text and binary output through a fixed-size buffer. It
+    formats integers and strings itself, which is where most of the time went when lists
+    were printed with one printf() per field, and leaves only decimal numbers to snprintf()
+    so they are rounded exactly as before.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include "output.h"
+
+/** The longest number writeFixed() and writeNumber() write, enough for any double */
+#define MAX_NUMBER_TEXT 400
+/** Numbers below this are written with one decimal place without snprintf(). Ten times
+    the limit is 2^52, past which the rounding below is no longer exact */
+#define FAST_TENTHS_LIMIT (4503599627370496.0 / 10)
+
+/**
+    This function finds the output format with the given name.
+    @param name as text, csv, jsonl or bin
+    @param format as where the format is stored
+    @return true if the name is a format.
+ */
+bool parseOutputFormat(char const *name, OutputFormat *format)
+{
+    static char const *const names[] = {"text", "csv", "jsonl", "bin"};
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *format = (OutputFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    This function starts a writer on a stream.
+    @param writer as the writer
+    @param fp as the stream being written to
+ */
+void openWriter(Writer *writer, FILE *fp)
+{
+    writer->fp = fp;
+    writer->used = 0;
+}
+
+/**
+    This function passes everything in the buffer on to the stream.
+    @param writer as the writer
+ */
+void flushWriter(Writer *writer)
+{
+    if (writer->used > 0)
+    {
+        fwrite(writer->buffer, 1, writer->used, writer->fp);
+        writer->used = 0;
+    }
+}
+
+/**
+    This function writes bytes.
+    @param writer as the writer
+    @param bytes as the bytes being written
+    @param length as the number of bytes
+ */
+void writeBytes(Writer *writer, void const *bytes, size_t length)
+{
+    if (writer->used + length > WRITER_BUFFER_SIZE)
+    {
+        flushWriter(writer);
+        if (length > WRITER_BUFFER_SIZE)
+        {
+            fwrite(bytes, 1, length, writer->fp);
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->used, bytes, length);
+    writer->used += length;
+}
+
+/**
+    This function writes the same character a number of times.
+    @param writer as the writer
+    @param c as the character
+    @param count as the number of times to write it
+ */
+static void writeRepeated(Writer *writer, char c, int count)
+{
+    if (count > 0 && writer->used + count <= WRITER_BUFFER_SIZE)
+    {
+        memset(writer->buffer + writer->used, c, count);
+        writer->used += count;
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        writeBytes(writer, &c, 1);
+    }
+}
+
+/**
+    This function writes a string.
+    @param writer as the writer
+    @param str as the string being written
+ */
+void writeText(Writer *writer, char const *str)
+{
+    writeBytes(writer, str, strlen(str));
+}
+
+/**
+    This function writes a string padded with spaces to a width, like printf("%-*s") when
+    left is true and printf("%*s") when it is false.
+    @param writer as the writer
+    @param str as the string being written
+    @param width as the least number of characters written
+    @param left as true to pad on the right
+ */
+void writePadded(Writer *writer, char const *str, int width, bool left)
+{
+    int length = strlen(str);
+    if (!left)
+    {
+        writeRepeated(writer, ' ', width - length);
+    }
+    writeBytes(writer, str, length);
+    if (left)
+    {
+        writeRepeated(writer, ' ', width - length);
+    }
+}
+
+/**
+    This function writes an integer padded with spaces to a width, like printf("%-*d") when
+    left is true and printf("%*d") when it is false.
+    @param writer as the writer
+    @param value as the integer being written
+    @param width as the least number of characters written
+    @param left as true to pad on the right
+ */
+void writeInteger(Writer *writer, long value, int width, bool left)
+{
+    char digits[24];
+    int start = sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do
+    {
+        digits[--start] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0)
+    {
+        digits[--start] = '-';
+    }
+
+    int length = sizeof(digits) - start;
+    if (!left)
+    {
+        writeRepeated(writer, ' ', width - length);
+    }
+    writeBytes(writer, digits + start, length);
+    if (left)
+    {
+        writeRepeated(writer, ' ', width - length);
+    }
+}
+
+/**
+    This function writes a number with a fixed number of decimal places, like
+    printf("%*.*f").
+    @param writer as the writer
+    @param value as the number being written
+    @param width as the least number of characters written
+    @param precision as the number of decimal places
+ */
+void writeFixed(Writer *writer, double value, int width, int precision)
+{
+    double magnitude = fabs(value);
+    if (precision == 1 && magnitude < FAST_TENTHS_LIMIT)
+    {
+        // fma() gives the error in magnitude * 10, so halves are found exactly and rounded
+        // to even, the way printf() rounds them
+        double scaled = magnitude * 10;
+        double error = fma(magnitude, 10, -scaled);
+        double tenths = floor(scaled);
+        double above = (scaled - tenths - 0.5) + error;
+        if (above > 0 || (above == 0 && fmod(tenths, 2) == 1))
+        {
+            tenths += 1;
+        }
+
+        char digits[24];
+        int start = sizeof(digits);
+        long long whole = (long long)tenths;
+        digits[--start] = '0' + whole % 10;
+        digits[--start] = '.';
+        whole /= 10;
+        do
+        {
+            digits[--start] = '0' + whole % 10;
+            whole /= 10;
+        } while (whole > 0);
+        if (signbit(value))
+        {
+            digits[--start] = '-';
+        }
+        int length = sizeof(digits) - start;
+        writeRepeated(writer, ' ', width - length);
+        writeBytes(writer, digits + start, length);
+        return;
+    }
+
+    char text[MAX_NUMBER_TEXT];
+    int length = snprintf(text, sizeof(text), "%*.*f", width, precision, value);
+    writeBytes(writer, text, length < (int)sizeof(text) ? length : (int)sizeof(text) - 1);
+}
+
+/**
+    This function writes a number with enough digits to read back the value it was
+    parsed from, like printf("%.15g").
+    @param writer as the writer
+    @param value as the number being written
+ */
+void writeNumber(Writer *writer, double value)
+{
+    char text[MAX_NUMBER_TEXT];
+    int length = snprintf(text, sizeof(text), "%.15g", value);
+    writeBytes(writer, text, length);
+}
+
+/**
+    This function writes a CSV field, quoting it if it holds a comma, quote or line break.
+    @param writer as the writer
+    @param str as the field being written
+ */
+void writeCsvField(Writer *writer, char const *str)
+{
+    if (strpbrk(str, ",\"\r\n") == NULL)
+    {
+        writeText(writer, str);
+        return;
+    }
+    writeBytes(writer, "\"", 1);
+    for (char const *p = str; *p != '\0'; p++)
+    {
+        if (*p == '"')
+        {
+            writeBytes(writer, "\"", 1);
+        }
+        writeBytes(writer, p, 1);
+    }
+    writeBytes(writer, "\"", 1);
+}
+
+/**
+    This function writes a JSON string, with quotes and escapes.
+    @param writer as the writer
+    @param str as the string being written
+ */
+void writeJsonString(Writer *writer, char const *str)
+{
+    writeBytes(writer, "\"", 1);
+    char const *run = str;
+    for (char const *p = str; *p != '\0'; p++)
+    {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        writeBytes(writer, run, p - run);
+        char escape[8];
+        if (c == '"' || c == '\\')
+        {
+            escape[0] = '\\';
+            escape[1] = c;
+            escape[2] = '\0';
+        }
+        else
+        {
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+        }
+        writeText(writer, escape);
+        run = p + 1;
+    }
+    writeText(writer, run);
+    writeBytes(writer, "\"", 1);
+}
+
+/**
+    This function writes a 32-bit integer in the machine's byte order.
+    @param writer as the writer
+    @param value as the integer being written
+ */
+void writeInt32(Writer *writer, long value)
+{
+    int32_t word = (int32_t)value;
+    writeBytes(writer, &word, sizeof(word));
+}
+
+/**
+    This function writes a column of names as binary output: the 32-bit end offset of each
+    name, the number of name bytes as a 32-bit integer, then the name bytes.
+    @param writer as the writer
+    @param names as the names being written
+    @param rows as the number of names
+ */
+void writeNameColumn(Writer *writer, char const *const *names, int rows)
+{
+    uint32_t end = 0;
+    for (int i = 0; i < rows; i++)
+    {
+        end += strlen(names[i]);
+        writeBytes(writer, &end, sizeof(end));
+    }
+    writeInt32(writer, end);
+    for (int i = 0; i < rows; i++)
+    {
+        writeText(writer, names[i]);
+    }
+}
@@ -0,0 +1,163 @@
+/**
+    @file output.h
+    @author Samuel E McConnell (semcconn)
+    This is the header file for output.c. This file lets the other components write lists
+    of parks through a fixed-size buffer in one of several output formats. It must be
+    included before catalog.h.
+*/
+
+/** The number of bytes a writer buffers before passing them on */
+#define WRITER_BUFFER_SIZE 65536
+/** The number of rows in each block of binary output */
+#define OUTPUT_BLOCK_ROWS 4096
+/** The county ID written in binary output when a park has no more counties */
+#define NO_COUNTY 0xFFFFFFFF
+/** The version of the binary output format */
+#define OUTPUT_VERSION 2
+/** The 4 bytes binary park output starts with */
+#define OUTPUT_PARKS_MAGIC "NCPB"
+/** The 4 bytes binary trip output starts with */
+#define OUTPUT_TRIP_MAGIC "NCTB"
+
+/**
+ * These are the formats lists of parks can be written in.
+ *
+ * OUTPUT_TEXT is the fixed-width table. OUTPUT_CSV has a header row and one row per park.
+ * OUTPUT_JSONL has one JSON object per park on each line.
+ *
+ * OUTPUT_BIN is a stream of column blocks in the machine's byte order. It starts with the
+ * 4 magic bytes and the version as a 32-bit integer, then has blocks of up to
+ * OUTPUT_BLOCK_ROWS rows, and ends with a block of 0 rows. Each block starts with its
+ * number of rows as a 32-bit integer. For parks, a block then has the number of counties
+ * seen for the first time in this block and their names (a byte of length, then the
+ * characters), which get the next county IDs in order, then the columns: 32-bit IDs,
+ * double latitudes, double longitudes, 32-bit end offsets of each name in the name bytes,
+ * the number of name bytes as a 32-bit integer, the name bytes, and MAX_COUNTIES 32-bit
+ * county IDs per park, NO_COUNTY when there are no more. For a trip, a block has the
+ * columns: 32-bit IDs, double distances, and the names as for parks.
+ */
+typedef enum OutputFormat
+{
+    OUTPUT_TEXT,
+    OUTPUT_CSV,
+    OUTPUT_JSONL,
+    OUTPUT_BIN
+} OutputFormat;
+
+/**
+ * This is the struct for a writer. Output is gathered in the buffer and passed on to the
+ * stream whenever the buffer fills, so memory use stays the same however much is written.
+ * @param fp as the stream being written to
+ * @param used as the number of bytes in the buffer
+ * @param buffer as the bytes not yet passed on
+ */
+typedef struct Writer
+{
+    FILE *fp;
+    size_t used;
+    char buffer[WRITER_BUFFER_SIZE];
+} Writer;
+
+/**
+    This function finds the output format with the given name.
+    @param name as text, csv, jsonl or bin
+    @param format as where the format is stored
+    @return true if the name is a format.
+ */
+bool parseOutputFormat(char const *name, OutputFormat *format);
+
+/**
+    This function starts a writer on a stream.
+    @param writer as the writer
+    @param fp as the stream being written to
+ */
+void openWriter(Writer *writer, FILE *fp);
+
+/**
+    This function passes everything in the buffer on to the stream.
+    @param writer as the writer
+ */
+void flushWriter(Writer *writer);
+
+/**
+    This function writes bytes.
+    @param writer as the writer
+    @param bytes as the bytes being written
+    @param length as the number of bytes
+ */
+void writeBytes(Writer *writer, void const *bytes, size_t length);
+
+/**
+    This function writes a string.
+    @param writer as the writer
+    @param str as the string being written
+ */
+void writeText(Writer *writer, char const *str);
+
+/**
+    This function writes a string padded with spaces to a width, like printf("%-*s") when
+    left is true and printf("%*s") when it is false.
+    @param writer as the writer
+    @param str as the string being written
+    @param width as the least number of characters written
+    @param left as true to pad on the right
+ */
+void writePadded(Writer *writer, char const *str, int width, bool left);
+
+/**
+    This function writes an integer padded with spaces to a width, like printf("%-*d") when
+    left is true and printf("%*d") when it is false.
+    @param writer as the writer
+    @param value as the integer being written
+    @param width as the least number of characters written
+    @param left as true to pad on the right
+ */
+void writeInteger(Writer *writer, long value, int width, bool left);
+
+/**
+    This function writes a number with a fixed number of decimal places, like
+    printf("%*.*f").
+    @param writer as the writer
+    @param value as the number being written
+    @param width as the least number of characters written
+    @param precision as the number of decimal places
+ */
+void writeFixed(Writer *writer, double value, int width, int precision);
+
+/**
+    This function writes a number with enough digits to read back the value it was
+    parsed from, like printf("%.15g").
+    @param writer as the writer
+    @param value as the number being written
+ */
+void writeNumber(Writer *writer, double value);
+
+/**
+    This function writes a CSV field, quoting it if it holds a comma, quote or line break.
+    @param writer as the writer
+    @param str as the field being written
+ */
+void writeCsvField(Writer *writer, char const *str);
+
+/**
+    This function writes a JSON string, with quotes and escapes.
+    @param writer as the writer
+    @param str as the string being written
+ */
+void writeJsonString(Writer *writer, char const *str);
+
+/**
+    This function writes a 32-bit integer in the machine's byte order.
+    @param writer as the writer
+    @param value as the integer being written
+ */
+void writeInt32(Writer *writer, long value);
+
+/**
+    This function writes a column of names as binary output: the 32-bit end offset of each
+    name, the number of name bytes as a 32-bit integer, then the name bytes.
+    @param writer as the writer
+    @param names as the names being written
+    @param rows as the number of names
+ */
+void writeNameColumn(Writer *writer, char const *const *names, int rows);
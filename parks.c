@@ -9,10 +9,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
 #include "input.h"
+#include "output.h"
 #include "catalog.h"
+#include "cache.h"
+#include "alloc.h"
+#include "matrix.h"
+#include "journal.h"
 
-/** The max line length of each line to be read from input */
+/** The max length of each word of a command */
 #define MAX_LINE_LENGTH 256
 
 /**
@@ -23,10 +30,11 @@
  */
 static Trip *makeTrip()
 {
-    Trip *trip = (Trip *)malloc(sizeof(Trip));
-    trip->parks = (Park **)malloc(sizeof(Park *) * INITIAL_CAPACITY);
+    Trip *trip = (Trip *)allocate(MEM_TRIP, sizeof(Trip));
+    trip->parks = (Park **)allocate(MEM_TRIP, sizeof(Park *) * INITIAL_CAPACITY);
     trip->count = 0;
     trip->capacity = INITIAL_CAPACITY;
+    trip->generation = 0;
     return trip;
 }
 
@@ -46,29 +54,25 @@ static void freeTrip(Trip *trip)
             trip->parks[i] = NULL;
         }
     }
-    free(trip->parks);
-    free(trip);
+    release(trip->parks);
+    release(trip);
 }
 
 /**
  * This function adds a park to the trip. It makes sure that the park exists in the catalog
  * and also that the park has not already been added.
+ * @param fp as the stream errors are printed to
  * @param catalog as the catalog
  * @param trip as the trip
  * @param id as the park's id that is being added
+ * @return true if the park was added.
  */
-static void addParkToTrip(Catalog *catalog, Trip *trip, int id)
+static bool addParkToTrip(FILE *fp, Catalog *catalog, Trip *trip, int id)
 {
     if (trip->count == trip->capacity)
     {
         trip->capacity *= 2;
-        Park **newParks = realloc(trip->parks, sizeof(Park *) * trip->capacity);
-        if (!newParks)
-        {
-            printf("Error: realloc failed\n");
-            exit(1);
-        }
-        trip->parks = newParks;
+        trip->parks = (Park **)reallocate(MEM_TRIP, trip->parks, sizeof(Park *) * trip->capacity);
     }
 
     bool check = false;
@@ -79,21 +83,24 @@ static void addParkToTrip(Catalog *catalog, Trip *trip, int id)
             check = true;
             trip->parks[trip->count] = catalog->parks[i];
             trip->count++;
+            trip->generation++;
         }
     }
     if (!check)
     {
-        printf("Invalid command\n");
+        fprintf(fp, "Invalid command\n");
     }
+    return check;
 }
 
 /**
  * This function removes a park from the trip. It makes sure that the park exists in the trip.
- * @param catalog as the catalog
+ * @param fp as the stream errors are printed to
  * @param trip as the trip
  * @param id as the park's id that is being removed.
+ * @return true if the park was removed.
  */
-static void removeParkFromTrip(Trip *trip, int parkID)
+static bool removeParkFromTrip(FILE *fp, Trip *trip, int parkID)
 {
     int index = -1;
     for (int i = 0; i < trip->count; i++)
@@ -113,106 +120,237 @@ static void removeParkFromTrip(Trip *trip, int parkID)
             trip->parks[i] = trip->parks[i + 1];
         }
         trip->count--;
+        trip->generation++;
+        return true;
     }
-    else
+    fprintf(fp, "Invalid command\n");
+    return false;
+}
+
+/**
+    This function writes one block of the trip as binary column output.
+    @param writer as the writer
+    @param rows as the parks in the block
+    @param distances as the distance to each park from the start of the trip
+    @param count as the number of parks in the block
+ */
+static void writeTripBlock(Writer *writer, Park **rows, double const *distances, int count)
+{
+    writeInt32(writer, count);
+    for (int r = 0; r < count; r++)
+    {
+        writeInt32(writer, rows[r]->id);
+    }
+    writeBytes(writer, distances, sizeof(double) * count);
+
+    char const **names = (char const **)allocate(MEM_QUERY, sizeof(char *) * count);
+    for (int r = 0; r < count; r++)
     {
-        printf("Invalid command\n");
+        names[r] = rows[r]->name;
     }
+    writeNameColumn(writer, names, count);
+    release(names);
 }
 
 /**
     This function prints all of the trip information. It uses the distance function to help
     calculate the distance from the first park that was added to the trip.
     @param trip as the trip being printed.
+    @param format as the output format.
  */
-static void listTrip(Trip *trip)
+static void listTrip(Trip *trip, OutputFormat format)
 {
-    printf("%-3s %-40s %8s\n", "ID", "Name", "Distance");
+    Writer *writer = (Writer *)allocate(MEM_OUTPUT, sizeof(Writer));
+    openWriter(writer, stdout);
+    double *distances = (double *)allocate(MEM_QUERY, sizeof(double) * OUTPUT_BLOCK_ROWS);
+    if (format == OUTPUT_TEXT)
+    {
+        writePadded(writer, "ID", 3, true);
+        writeText(writer, " ");
+        writePadded(writer, "Name", MAX_NAME_LENGTH, true);
+        writeText(writer, " ");
+        writePadded(writer, "Distance", 8, false);
+        writeText(writer, "\n");
+    }
+    else if (format == OUTPUT_CSV)
+    {
+        writeText(writer, "id,name,distance\n");
+    }
+    else if (format == OUTPUT_BIN)
+    {
+        writeBytes(writer, OUTPUT_TRIP_MAGIC, 4);
+        writeInt32(writer, OUTPUT_VERSION);
+    }
+
     double totalDistance = 0.0;
     Park *previousPark = NULL;
+    int blockStart = 0;
     for (int i = 0; i < trip->count; i++)
     {
         Park *park = trip->parks[i];
         double dist = (previousPark != NULL) ? distance(previousPark, park) : 0.0;
         totalDistance += dist;
-        printf("%-3d %-40s %8.1f\n", park->id, park->name, totalDistance);
         previousPark = park;
+
+        if (format == OUTPUT_TEXT)
+        {
+            writeInteger(writer, park->id, 3, true);
+            writeText(writer, " ");
+            writePadded(writer, park->name, MAX_NAME_LENGTH, true);
+            writeText(writer, " ");
+            writeFixed(writer, totalDistance, 8, 1);
+            writeText(writer, "\n");
+        }
+        else if (format == OUTPUT_CSV)
+        {
+            writeInteger(writer, park->id, 0, true);
+            writeText(writer, ",");
+            writeCsvField(writer, park->name);
+            writeText(writer, ",");
+            writeNumber(writer, totalDistance);
+            writeText(writer, "\n");
+        }
+        else if (format == OUTPUT_JSONL)
+        {
+            writeText(writer, "{\"id\":");
+            writeInteger(writer, park->id, 0, true);
+            writeText(writer, ",\"name\":");
+            writeJsonString(writer, park->name);
+            writeText(writer, ",\"distance\":");
+            writeNumber(writer, totalDistance);
+            writeText(writer, "}\n");
+        }
+        else
+        {
+            distances[i - blockStart] = totalDistance;
+            if (i + 1 - blockStart == OUTPUT_BLOCK_ROWS)
+            {
+                writeTripBlock(writer, trip->parks + blockStart, distances, OUTPUT_BLOCK_ROWS);
+                blockStart = i + 1;
+            }
+        }
+    }
+    if (format == OUTPUT_BIN)
+    {
+        if (trip->count > blockStart)
+        {
+            writeTripBlock(writer, trip->parks + blockStart, distances, trip->count - blockStart);
+        }
+        writeInt32(writer, 0);
     }
+
+    flushWriter(writer);
+    release(distances);
+    release(writer);
 }
 
+/**
+ * This is the struct for a park found by getNearest().
+ * @param park as the park
+ * @param dist as the distance from the last park in the trip
+ * @param rank as the position of the park in the order the catalog is listed in
+ */
+typedef struct NearPark
+{
+    Park *park;
+    double dist;
+    int rank;
+} NearPark;
+
 /**
     This function finds the nearest parks from the last park that you added to the trip.
-    It will sort through the catalog and find the amount of trips that you requested and prints
-    them.
+    It walks the parks in the order they are stored, which follows a Hilbert curve, and keeps
+    the closest ones found so far in a sorted list. Parks at the same distance are listed in
+    the order the catalog is currently listed in.
+    @param fp as the stream the parks are printed to
     @param catalog as the catalog
     @param trip as the trip
     @param amount as the amount of parks you would like to be listed.
  */
-static void getNearest(Catalog *catalog, Trip *trip, int amount)
+static void getNearest(FILE *fp, Catalog *catalog, Trip *trip, int amount)
 {
     if (amount <= 0 || trip->count == 0)
     {
-        printf("Invalid command\n");
+        fprintf(fp, "Invalid command\n");
         return;
     }
 
-    if (amount > catalog->count)
+    if (amount >= catalog->count)
     {
         amount = catalog->count - 1;
     }
 
-    Park **nearestList = (Park **)malloc(sizeof(Park) * (amount + 1));
-    nearestList[0] = trip->parks[trip->count - 1];
-    for (int i = 1; i <= amount; i++)
+    Park *origin = trip->parks[trip->count - 1];
+    NearPark *nearestList = (NearPark *)allocate(MEM_QUERY, sizeof(NearPark) * amount);
+    int found = 0;
+    for (int i = 0; i < catalog->count; i++)
     {
-        for (int j = 0; j < catalog->count; j++)
+        Park *park = &catalog->store[i];
+        if (park == origin)
         {
-            if (j == 0)
-            {
-                for (int x = 0; x <= amount; x++)
-                {
-                    if (nearestList[x] == NULL)
-                    {
-                        break;
-                    }
-                    if (catalog->parks[j]->id == nearestList[x]->id)
-                    {
-                        j++;
-                        x = 0;
-                    }
-                }
-                nearestList[i] = catalog->parks[j];
-            }
+            continue;
+        }
 
-            bool isInNearestList = false;
-            for (int y = 0; y < i; y++)
-            {
-                if (nearestList[y] == NULL)
-                {
-                    break;
-                }
-                if (catalog->parks[j]->id + 1 == nearestList[y]->id + 1)
-                {
-                    isInNearestList = true;
-                }
-            }
+        double dist = distance(origin, park);
+        int rank = catalog->rank[i];
+        int position = found;
+        while (position > 0 && (dist < nearestList[position - 1].dist ||
+                                (dist == nearestList[position - 1].dist && rank < nearestList[position - 1].rank)))
+        {
+            position--;
+        }
+        if (position >= amount)
+        {
+            continue;
+        }
 
-            if (distance(nearestList[0], catalog->parks[j]) < distance(nearestList[0], nearestList[i]) && !isInNearestList)
-            {
-                nearestList[i] = catalog->parks[j];
-            }
+        int moved = (found < amount ? found : amount - 1) - position;
+        memmove(&nearestList[position + 1], &nearestList[position], sizeof(NearPark) * moved);
+        nearestList[position].park = park;
+        nearestList[position].dist = dist;
+        nearestList[position].rank = rank;
+        if (found < amount)
+        {
+            found++;
         }
     }
 
-    printf("%-3s %-40s %8s\n", "ID", "Name", "Distance");
-    for (int i = 0; i <= amount; i++)
+    fprintf(fp, "%-3s %-40s %8s\n", "ID", "Name", "Distance");
+    fprintf(fp, "%-3d %-40s %8.1f\n", origin->id, origin->name, distance(origin, origin));
+    for (int i = 0; i < found; i++)
     {
-        Park *park = nearestList[i];
-        double dist = distance(nearestList[0], park);
-        printf("%-3d %-40s %8.1f\n", park->id, park->name, dist);
+        Park *park = nearestList[i].park;
+        fprintf(fp, "%-3d %-40s %8.1f\n", park->id, park->name, nearestList[i].dist);
+    }
+
+    release(nearestList);
+}
+
+/**
+    This function prints the distance between every pair of parks in the trip, or writes
+    it to a file in binary form.
+    @param fp as the stream the table and errors are printed to
+    @param trip as the trip
+    @param filename as the file to write, or NULL to print a table
+ */
+static void tripMatrix(FILE *fp, Trip *trip, char const *filename)
+{
+    if (trip->count == 0)
+    {
+        fprintf(fp, "Invalid command\n");
+        return;
     }
 
-    free(nearestList);
+    double *matrix = distanceMatrix(trip->parks, trip->count);
+    if (filename == NULL)
+    {
+        printMatrix(fp, trip->parks, trip->count, matrix);
+    }
+    else if (!writeMatrix(filename, trip->parks, trip->count, matrix))
+    {
+        fprintf(fp, "Can't write file: %s\n", filename);
+    }
+    release(matrix);
 }
 
 /**
@@ -279,6 +417,122 @@ static bool countyTestFunction(Park const *park, char const *str)
     return false;
 }
 
+/** The number of bytes a rendered query result starts with room for */
+#define QUERY_TEXT_SIZE 4096
+
+/**
+ * This is the struct for the rendered output of a query. It is kept in memory from
+ * allocate(), so it is counted in the memory report.
+ * @param text as the output
+ * @param length as the number of bytes of output
+ * @param capacity as the number of bytes text can hold
+ */
+typedef struct QueryText
+{
+    char *text;
+    size_t length;
+    size_t capacity;
+} QueryText;
+
+/**
+    This function adds bytes written to a query stream to its text, growing the text when
+    it is full.
+    @param cookie as the QueryText
+    @param bytes as the bytes written
+    @param size as the number of bytes
+    @return the number of bytes written.
+ */
+static ssize_t writeQueryText(void *cookie, char const *bytes, size_t size)
+{
+    QueryText *query = (QueryText *)cookie;
+    if (query->length + size > query->capacity)
+    {
+        while (query->length + size > query->capacity)
+        {
+            query->capacity *= 2;
+        }
+        query->text = (char *)reallocate(MEM_QUERY, query->text, query->capacity);
+    }
+    memcpy(query->text + query->length, bytes, size);
+    query->length += size;
+    return size;
+}
+
+/**
+    This function prints the result of a read-only query, either from the cache or by
+    rendering it and caching the output. Results for nearest depend on the trip, list
+    results only depend on the catalog.
+    @param cache as the cache of rendered results
+    @param key as the command and arguments identifying the result
+    @param catalog as the catalog
+    @param trip as the trip
+    @param county as the county to list, or NULL to list every park
+    @param amount as the amount of parks for nearest, only used when usesTrip is true
+    @param usesTrip as true for nearest and false for the list commands
+    @param format as the output format for the list commands
+    @param out as the stream the result is printed to
+ */
+static void cachedQuery(Cache *cache, char const *key, Catalog *catalog, Trip *trip,
+                        char const *county, int amount, bool usesTrip, OutputFormat format, FILE *out)
+{
+    // Output that would not fit in the cache is written straight out instead
+    long rows = usesTrip ? (long)amount + 1 : catalog->count;
+    if (rows > CACHE_MAX_ROWS)
+    {
+        if (usesTrip)
+        {
+            getNearest(out, catalog, trip, amount);
+        }
+        else
+        {
+            listParks(out, catalog, countyTestFunction, county, format);
+        }
+        return;
+    }
+
+    size_t length;
+    char const *cached = cacheLookup(cache, key, catalog->generation, trip->generation, &length);
+    if (cached != NULL)
+    {
+        fwrite(cached, 1, length, out);
+        return;
+    }
+
+    QueryText query = {(char *)allocate(MEM_QUERY, QUERY_TEXT_SIZE), 0, QUERY_TEXT_SIZE};
+    cookie_io_functions_t functions = {NULL, writeQueryText, NULL, NULL};
+    FILE *fp = fopencookie(&query, "w", functions);
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: fopencookie failed\n");
+        exit(EXIT_FAILURE);
+    }
+    if (usesTrip)
+    {
+        getNearest(fp, catalog, trip, amount);
+    }
+    else
+    {
+        listParks(fp, catalog, countyTestFunction, county, format);
+    }
+    fclose(fp);
+
+    fwrite(query.text, 1, query.length, out);
+    cacheStore(cache, key, query.text, query.length, catalog->generation, trip->generation, usesTrip);
+    release(query.text);
+}
+
+/**
+    This function returns the number of seconds since the given time.
+    @param start as the time to measure from, from the monotonic clock
+    @return the seconds since start.
+ */
+static double secondsSince(struct timespec const *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
 /**
     This is the main function of the program. It will start the prgram and call all the required
     functions to make the program run correctly. This function also takes on the files it needs to read.
@@ -288,101 +542,227 @@ static bool countyTestFunction(Park const *park, char const *str)
  */
 int main(int argc, char *argv[])
 {
+    // Options are taken out of argv, leaving the park files in argv[1] to argv[fileCount]
+    bool memoryReport = false;
+    char const *recordFile = NULL;
+    char const *journalFile = NULL;
+    OutputFormat format = OUTPUT_TEXT;
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--memory-report") == 0)
+        {
+            memoryReport = true;
+        }
+        else if (strncmp(argv[i], "--output=", strlen("--output=")) == 0)
+        {
+            if (!parseOutputFormat(argv[i] + strlen("--output="), &format))
+            {
+                fprintf(stderr, "usage: parks <park-file>*\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--record") == 0)
+        {
+            if (i + 1 == argc)
+            {
+                fprintf(stderr, "usage: parks <park-file>*\n");
+                return EXIT_FAILURE;
+            }
+            i++;
+            recordFile = argv[i];
+        }
+        else if (strcmp(argv[i], "--journal") == 0)
+        {
+            if (i + 1 == argc)
+            {
+                fprintf(stderr, "usage: parks <park-file>*\n");
+                return EXIT_FAILURE;
+            }
+            i++;
+            journalFile = argv[i];
+        }
+        else
+        {
+            fileCount++;
+            argv[fileCount] = argv[i];
+        }
+    }
 
-    if (argc < 2)
+    if (fileCount < 1)
     {
         fprintf(stderr, "usage: parks <park-file>*\n");
         return EXIT_FAILURE;
     }
 
+    // Each command is logged with the seconds since startup, for the replay program
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    FILE *record = NULL;
+    if (recordFile != NULL)
+    {
+        record = fopen(recordFile, "w");
+        if (record == NULL)
+        {
+            fprintf(stderr, "Can't open file: %s\n", recordFile);
+            return EXIT_FAILURE;
+        }
+    }
+
     Catalog *catalog = makeCatalog();
 
     Trip *trip = makeTrip();
 
-    for (int i = 1; i < argc; i++)
+    Cache *cache = makeCache();
+
+    for (int i = 1; i <= fileCount; i++)
     {
         readParks(argv[i], catalog);
     }
+    indexCatalog(catalog, compareParksByID, compareParksByName);
+
+    // The trip from the last run is rebuilt before the first command
+    Journal *journal = NULL;
+    if (journalFile != NULL)
+    {
+        journal = openJournal(journalFile, catalog, trip);
+    }
 
-    char input[MAX_LINE_LENGTH];
+    // The order the catalog is listed in: 'f' for file order, 'i' for ID, 'n' for name
+    char order = 'f';
+    char key[MAX_LINE_LENGTH * 2];
+    // With a format for other programs, stdout only gets the results of the list and trip
+    // commands, and everything else goes to stderr
+    FILE *console = (format == OUTPUT_TEXT) ? stdout : stderr;
+    LineReader *reader = makeLineReader(STDIN_FILENO);
     while (1)
     {
-        printf("cmd> ");
-        if (fgets(input, sizeof(input), stdin) == NULL)
+        if (format == OUTPUT_TEXT)
+        {
+            printf("cmd> ");
+            fflush(stdout);
+        }
+        size_t inputLength;
+        char *input = nextLine(reader, &inputLength);
+        if (input == NULL)
         {
             break;
         }
 
-        size_t input_length = strlen(input);
-        if (input_length > 0 && input[input_length - 1] == '\n')
+        if (record != NULL)
         {
-            input[input_length - 1] = '\0';
+            fprintf(record, "%.6f %s\n", secondsSince(&start), input);
+            fflush(record);
         }
 
         char cmd[MAX_LINE_LENGTH];
-        char param1[MAX_LINE_LENGTH];
-        char param2[MAX_LINE_LENGTH];
-        int result = sscanf(input, "%s %s %s", cmd, param1, param2);
+        char param1[MAX_LINE_LENGTH] = "";
+        char param2[MAX_LINE_LENGTH] = "";
+        // Each word is cut off at MAX_LINE_LENGTH - 1 characters
+        int result = sscanf(input, "%255s %255s %255s", cmd, param1, param2);
+        if (format == OUTPUT_TEXT)
+        {
+            printf("%s\n", input);
+        }
 
         if (result == 1 && strcmp(cmd, "quit") == 0)
         {
-            printf("%s\n", input);
             break;
         }
         else if (result >= 1 && strcmp(cmd, "list") == 0)
         {
             if (strcmp(param1, "parks") == 0)
             {
-                printf("%s\n", input);
-                sortParks(catalog, compareParksByID);
-                listParks(catalog, countyTestFunction, NULL);
+                if (order != 'i')
+                {
+                    viewParks(catalog, catalog->byId);
+                    order = 'i';
+                }
+                cachedQuery(cache, "list parks", catalog, trip, NULL, 0, false, format, stdout);
             }
             else if (strcmp(param1, "names") == 0)
             {
-                printf("%s\n", input);
-                sortParks(catalog, compareParksByName);
-                listParks(catalog, countyTestFunction, NULL);
+                if (order != 'n')
+                {
+                    viewParks(catalog, catalog->byName);
+                    order = 'n';
+                }
+                cachedQuery(cache, "list names", catalog, trip, NULL, 0, false, format, stdout);
             }
             else if (strcmp(param1, "county") == 0)
             {
-                printf("%s\n", input);
-                listParks(catalog, countyTestFunction, param2);
+                snprintf(key, sizeof(key), "%c list county %s", order, param2);
+                cachedQuery(cache, key, catalog, trip, param2, 0, false, format, stdout);
             }
             else
             {
-                printf("%s\n", input);
-                printf("Invalid command\n");
+                fprintf(console, "Invalid command\n");
             }
         }
         else if (result >= 1 && strcmp(cmd, "add") == 0)
         {
-            printf("%s\n", input);
-            addParkToTrip(catalog, trip, atoi(param1));
+            int id = atoi(param1);
+            if (addParkToTrip(console, catalog, trip, id) && journal != NULL)
+            {
+                journalChange(journal, trip, JOURNAL_ADD, id, 0);
+            }
         }
         else if (result >= 1 && strcmp(cmd, "remove") == 0)
         {
-            printf("%s\n", input);
-            removeParkFromTrip(trip, atoi(param1));
+            int id = atoi(param1);
+            if (removeParkFromTrip(console, trip, id) && journal != NULL)
+            {
+                journalChange(journal, trip, JOURNAL_REMOVE, id, 0);
+            }
         }
         else if (result >= 1 && strcmp(cmd, "trip") == 0)
         {
-            printf("%s\n", input);
-            listTrip(trip);
+            listTrip(trip, format);
         }
         else if (result >= 1 && strcmp(cmd, "nearest") == 0)
         {
-            printf("%s\n", input);
-            getNearest(catalog, trip, atoi(param1));
+            int amount = atoi(param1);
+            snprintf(key, sizeof(key), "%c nearest %d", order, amount);
+            cachedQuery(cache, key, catalog, trip, NULL, amount, true, format, console);
+        }
+        else if (result >= 1 && strcmp(cmd, "matrix") == 0)
+        {
+            tripMatrix(console, trip, result >= 2 ? param1 : NULL);
+        }
+        else if (result == 1 && strcmp(cmd, "cache") == 0)
+        {
+            printCacheStats(console, cache);
+        }
+        else if (result == 1 && strcmp(cmd, "memory") == 0)
+        {
+            printMemoryReport(console);
         }
         else
         {
-            printf("%s\n", input);
-            printf("Invalid command\n");
+            fprintf(console, "Invalid command\n");
+        }
+        if (format == OUTPUT_TEXT)
+        {
+            printf("\n");
         }
-        printf("\n");
+    }
+    freeLineReader(reader);
+    if (journal != NULL)
+    {
+        closeJournal(journal, trip);
     }
     freeCatalog(catalog);
     freeTrip(trip);
+    freeCache(cache);
+    if (record != NULL)
+    {
+        fclose(record);
+    }
+
+    if (memoryReport)
+    {
+        printMemoryReport(stderr);
+    }
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
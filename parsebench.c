@@ -0,0 +1,185 @@
+/**
+    @file parsebench.c
+    @author Samuel E McConnell (semcconn)
+    This program measures how fast park records are parsed. It builds a block of generated
+    park records in memory, checks the parsed values against sscanf() and strtod(), and
+    then times parseParkRecord() over the whole block to report the throughput in GB/s.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "output.h"
+#include "catalog.h"
+
+/** The number of records generated when no count is given */
+#define DEFAULT_RECORDS 1000000
+
+/** The number of times the block of records is parsed */
+#define REPETITIONS 10
+
+/** The longest generated record line */
+#define MAX_RECORD_LENGTH 128
+
+/** County names used in generated records */
+static char const *const COUNTY_NAMES[] = {"Wake", "Durham", "Orange", "Chatham", "Johnston",
+                                           "Mecklenburg", "Buncombe", "Dare", "NewHanover"};
+
+/**
+    This function returns the current time in seconds.
+    @return the time from a monotonic clock.
+ */
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+    This function checks one parsed record against sscanf(), which is how records used
+    to be parsed.
+    @param line as the record line
+    @param park as the park parseParkRecord() filled in
+    @return true if the ID, latitude and longitude match.
+ */
+static bool matchesReference(char const *line, Park const *park)
+{
+    int id;
+    double lat, lon;
+    if (sscanf(line, "%d %lf %lf", &id, &lat, &lon) != 3)
+    {
+        return false;
+    }
+    return id == park->id && lat == park->lat && lon == park->lon;
+}
+
+/**
+ * This is the struct for a record with a known result, to check the edge cases.
+ * @param line as the record line
+ * @param valid as true if the record should parse
+ * @param counties as the counties it should have, separated by single spaces
+ */
+typedef struct EdgeCase
+{
+    char const *line;
+    bool valid;
+    char const *counties;
+} EdgeCase;
+
+/** Records whose handling must not change */
+static EdgeCase const EDGE_CASES[] = {
+    {"1 35.1 -79.2 Wake", true, "Wake"},
+    {"1 35.1 -79.2 Wake Dare", true, "Wake Dare"},
+    {"1 35.1 -79.2 Wake ", true, "Wake"},
+    {"1 35.1 -79.2 Wake Dare ", true, "Wake Dare"},
+    {"1 35.1 -79.2 Wake  Dare", false, ""},
+    {"1  35.1 -79.2 Wake", false, ""},
+    {"1 35.1 -79.2", false, ""},
+};
+
+/**
+    This function checks that each edge case parses or fails as it should, with the
+    right counties.
+    @return true if every edge case matched.
+ */
+static bool checkEdgeCases()
+{
+    Park park;
+    for (int i = 0; i < sizeof(EDGE_CASES) / sizeof(EDGE_CASES[0]); i++)
+    {
+        EdgeCase const *edge = &EDGE_CASES[i];
+        bool valid = parseParkRecord(edge->line, strlen(edge->line), &park);
+        char counties[MAX_COUNTIES * (MAX_COUNTIES_NAME_LENGTH + 1) + 1] = "";
+        for (int c = 0; valid && c < MAX_COUNTIES && park.counties[c][0] != '\0'; c++)
+        {
+            if (c > 0)
+            {
+                strcat(counties, " ");
+            }
+            strcat(counties, park.counties[c]);
+        }
+        if (valid != edge->valid || (valid && strcmp(counties, edge->counties) != 0))
+        {
+            fprintf(stderr, "Mismatch on record: %s\n", edge->line);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    This is the main function of the benchmark.
+    @param argc as the amount of arguments.
+    @param argv as the list of arguments, optionally the number of records.
+    @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int main(int argc, char *argv[])
+{
+    int records = argc > 1 ? atoi(argv[1]) : DEFAULT_RECORDS;
+    if (records <= 0)
+    {
+        fprintf(stderr, "usage: parsebench [records]\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!checkEdgeCases())
+    {
+        return EXIT_FAILURE;
+    }
+
+    char *block = (char *)malloc((size_t)records * MAX_RECORD_LENGTH);
+    size_t *starts = (size_t *)malloc(sizeof(size_t) * records);
+    size_t *lengths = (size_t *)malloc(sizeof(size_t) * records);
+    int countyTotal = sizeof(COUNTY_NAMES) / sizeof(COUNTY_NAMES[0]);
+
+    srand(1);
+    size_t size = 0;
+    for (int i = 0; i < records; i++)
+    {
+        double lat = 33.8 + (rand() % 280000) / 100000.0;
+        double lon = -84.3 + (rand() % 880000) / 100000.0;
+        int length = snprintf(block + size, MAX_RECORD_LENGTH, "%d %.5f %.5f %s %s", i + 1, lat,
+                              lon, COUNTY_NAMES[i % countyTotal],
+                              COUNTY_NAMES[(i / countyTotal) % countyTotal]);
+        starts[i] = size;
+        lengths[i] = length;
+        size += length + 1;
+    }
+
+    Park park;
+    for (int i = 0; i < records; i++)
+    {
+        if (!parseParkRecord(block + starts[i], lengths[i], &park) ||
+            !matchesReference(block + starts[i], &park))
+        {
+            fprintf(stderr, "Mismatch on record: %s\n", block + starts[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    double start = now();
+    long checksum = 0;
+    for (int r = 0; r < REPETITIONS; r++)
+    {
+        for (int i = 0; i < records; i++)
+        {
+            parseParkRecord(block + starts[i], lengths[i], &park);
+            checksum += park.id;
+        }
+    }
+    double seconds = now() - start;
+
+    double bytes = (double)size * REPETITIONS;
+    printf("%-10s %d\n", "Records", records);
+    printf("%-10s %.1f MB\n", "Parsed", bytes / 1e6);
+    printf("%-10s %.3f s\n", "Time", seconds);
+    printf("%-10s %.3f GB/s\n", "Throughput", bytes / seconds / 1e9);
+    printf("%-10s %ld\n", "Checksum", checksum);
+
+    free(block);
+    free(starts);
+    free(lengths);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,570 @@
+/**
+    @file replay.c
+    @author Samuel E McConnell (semcconn)
+    This program replays a log of commands against the parks program to measure how it
+    performs under load. The log is either one recorded with parks --record, a plain file
+    of commands like the test inputs, or a synthetic mix of commands made up from the park
+    files. Each session is a separate parks process that is sent the whole log, one command
+    at a time. A command counts as done when parks prints its next prompt. At the end the
+    program reports throughput and latency percentiles.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "input.h"
+#include "output.h"
+#include "catalog.h"
+#include "alloc.h"
+
+/** The most sessions that can run at once */
+#define MAX_SESSIONS 64
+
+/** The prompt parks prints when it is ready for the next command */
+#define PROMPT "cmd> "
+
+/** The number of bytes read from a session at a time */
+#define READ_BUFFER_SIZE 65536
+
+/** The most parks a synthetic nearest command asks for */
+#define SYNTHETIC_NEAREST 10
+
+/**
+ * This is the struct for one command in the log.
+ * @param time as the seconds since the start of the log the command was sent at
+ * @param text as the command
+ */
+typedef struct Command
+{
+    double time;
+    char *text;
+} Command;
+
+/**
+ * This is the struct for the log of commands. It has 3 variable to it.
+ * @param commands as the list of commands
+ * @param count as the count of commands in the log
+ * @param capacity as the max amount of commands in the log.
+ */
+typedef struct Log
+{
+    Command *commands;
+    int count;
+    int capacity;
+} Log;
+
+/**
+ * This is the struct for one running parks process.
+ * @param pid as the process ID
+ * @param in as the pipe the commands are written to
+ * @param out as the pipe the output is read from
+ * @param next as the index of the next command to send
+ * @param waiting as true while waiting for a prompt
+ * @param sentAt as the time the command being waited on was due, or a negative number
+ *        while waiting for the first prompt
+ * @param matched as how many characters of the prompt the output ended with so far
+ * @param lineStart as true when the next character of output starts a line
+ * @param done as true once the process has closed its output
+ */
+typedef struct Session
+{
+    pid_t pid;
+    int in;
+    int out;
+    int next;
+    bool waiting;
+    double sentAt;
+    int matched;
+    bool lineStart;
+    bool done;
+} Session;
+
+/**
+    This function returns the current time in seconds.
+    @return the time from a monotonic clock.
+ */
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+    This function prints how to run the program and exits.
+ */
+static void usage()
+{
+    fprintf(stderr, "usage: replay [-c sessions] [-r rate] [-t] (-l log | -n count) "
+                    "<parks-program> <park-file>*\n");
+    exit(EXIT_FAILURE);
+}
+
+/**
+    This function adds a command to the end of the log.
+    @param log as the log
+    @param time as the seconds since the start of the log
+    @param text as the command, which the log takes ownership of
+ */
+static void addCommand(Log *log, double time, char *text)
+{
+    if (log->count == log->capacity)
+    {
+        log->capacity *= 2;
+        log->commands = (Command *)reallocate(MEM_IO, log->commands, sizeof(Command) * log->capacity);
+    }
+    log->commands[log->count].time = time;
+    log->commands[log->count].text = text;
+    log->count++;
+}
+
+/**
+    This function reads a log of commands. Lines recorded by parks --record start with a
+    timestamp, and lines without one are given the time 0. Commands never start with a
+    digit, so the two kinds of line can be told apart.
+    @param filename as the name of the log file
+    @param log as the log the commands are added to
+ */
+static void readLog(char const *filename, Log *log)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Can't open file: %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    char *line;
+    while ((line = readLine(fp)) != NULL)
+    {
+        double time = 0.0;
+        char *text = line;
+        if ((line[0] >= '0' && line[0] <= '9') || line[0] == '.')
+        {
+            time = strtod(line, &text);
+            if (*text == ' ')
+            {
+                text++;
+            }
+        }
+
+        char *command = (char *)allocate(MEM_IO, strlen(text) + 1);
+        strcpy(command, text);
+        release(line);
+        addCommand(log, time, command);
+    }
+    fclose(fp);
+}
+
+/**
+    This function makes up a log of commands from the parks in the given files. The mix
+    leans on the read-only commands, with enough add and remove commands to keep the trip
+    changing.
+    @param count as the number of commands to make
+    @param files as the park files
+    @param fileCount as the number of park files
+    @param log as the log the commands are added to
+ */
+static void syntheticLog(int count, char *files[], int fileCount, Log *log)
+{
+    Catalog *catalog = makeCatalog();
+    for (int i = 0; i < fileCount; i++)
+    {
+        readParks(files[i], catalog);
+    }
+    if (catalog->count == 0)
+    {
+        fprintf(stderr, "No parks to make commands from\n");
+        exit(EXIT_FAILURE);
+    }
+
+    srand(1);
+    char text[MAX_NAME_LENGTH * 2];
+    for (int i = 0; i < count; i++)
+    {
+        Park *park = catalog->parks[rand() % catalog->count];
+        int pick = rand() % 100;
+        if (pick < 25)
+        {
+            snprintf(text, sizeof(text), "list county %s", park->counties[0]);
+        }
+        else if (pick < 35)
+        {
+            snprintf(text, sizeof(text), "list names");
+        }
+        else if (pick < 45)
+        {
+            snprintf(text, sizeof(text), "list parks");
+        }
+        else if (pick < 65)
+        {
+            snprintf(text, sizeof(text), "nearest %d", 1 + rand() % SYNTHETIC_NEAREST);
+        }
+        else if (pick < 80)
+        {
+            snprintf(text, sizeof(text), "add %d", park->id);
+        }
+        else if (pick < 90)
+        {
+            snprintf(text, sizeof(text), "remove %d", park->id);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "trip");
+        }
+
+        char *command = (char *)allocate(MEM_IO, strlen(text) + 1);
+        strcpy(command, text);
+        addCommand(log, 0.0, command);
+    }
+    freeCatalog(catalog);
+}
+
+/**
+    This function starts a parks process with its input and output connected to pipes.
+    @param session as the session being started
+    @param argv as the program and its arguments
+ */
+static void startSession(Session *session, char *argv[])
+{
+    int inPipe[2];
+    int outPipe[2];
+    if (pipe(inPipe) != 0 || pipe(outPipe) != 0)
+    {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+
+    session->pid = fork();
+    if (session->pid < 0)
+    {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (session->pid == 0)
+    {
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        close(inPipe[0]);
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(outPipe[1]);
+        execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+
+    close(inPipe[0]);
+    close(outPipe[1]);
+    session->in = inPipe[1];
+    session->out = outPipe[0];
+    session->next = 0;
+    session->waiting = true;
+    session->sentAt = -1.0;
+    session->matched = 0;
+    session->lineStart = true;
+    session->done = false;
+}
+
+/**
+    This function writes a whole command to a session.
+    @param session as the session
+    @param text as the command
+    @return false if the session has stopped reading commands.
+ */
+static bool sendCommand(Session *session, char const *text)
+{
+    size_t length = strlen(text);
+    char *line = (char *)allocate(MEM_QUERY, length + 1);
+    memcpy(line, text, length);
+    line[length] = '\n';
+
+    size_t written = 0;
+    while (written < length + 1)
+    {
+        ssize_t n = write(session->in, line + written, length + 1 - written);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            release(line);
+            return false;
+        }
+        written += n;
+    }
+    release(line);
+    return true;
+}
+
+/**
+    This function compares two latencies for sorting.
+    @param a as a latency being compared
+    @param b as a latency being compared
+    @return an int value to sort.
+ */
+static int compareLatencies(const void *a, const void *b)
+{
+    double latencyA = *(double const *)a;
+    double latencyB = *(double const *)b;
+    return (latencyA < latencyB) ? -1 : (latencyA > latencyB);
+}
+
+/**
+    This function returns a percentile of a sorted list of latencies.
+    @param latencies as the sorted latencies
+    @param count as the number of latencies
+    @param percent as the percentile wanted
+    @return the latency at that percentile.
+ */
+static double percentile(double const *latencies, long count, double percent)
+{
+    long index = (long)ceil(percent / 100.0 * count) - 1;
+    if (index < 0)
+    {
+        index = 0;
+    }
+    return latencies[index];
+}
+
+/**
+    This is the main function of the replay program.
+    @param argc as the amount of arguments.
+    @param argv as the list of arguments.
+    @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int main(int argc, char *argv[])
+{
+    int sessionCount = 1;
+    double rate = 0.0;
+    bool recordedTiming = false;
+    char const *logFile = NULL;
+    int synthetic = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "+c:r:tl:n:")) != -1)
+    {
+        switch (option)
+        {
+        case 'c':
+            sessionCount = atoi(optarg);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 't':
+            recordedTiming = true;
+            break;
+        case 'l':
+            logFile = optarg;
+            break;
+        case 'n':
+            synthetic = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind >= argc || sessionCount < 1 || sessionCount > MAX_SESSIONS || rate < 0 ||
+        (logFile == NULL) == (synthetic <= 0))
+    {
+        usage();
+    }
+
+    Log log;
+    log.capacity = INITIAL_CAPACITY;
+    log.count = 0;
+    log.commands = (Command *)allocate(MEM_IO, sizeof(Command) * log.capacity);
+    if (logFile != NULL)
+    {
+        readLog(logFile, &log);
+    }
+    else
+    {
+        syntheticLog(synthetic, argv + optind + 1, argc - optind - 1, &log);
+    }
+    double firstTime = log.count > 0 ? log.commands[0].time : 0.0;
+
+    signal(SIGPIPE, SIG_IGN);
+    Session sessions[MAX_SESSIONS];
+    for (int i = 0; i < sessionCount; i++)
+    {
+        startSession(&sessions[i], argv + optind);
+    }
+
+    long latencyCapacity = (long)log.count * sessionCount + 1;
+    double *latencies = (double *)allocate(MEM_QUERY, sizeof(double) * latencyCapacity);
+    long latencyCount = 0;
+    char buffer[READ_BUFFER_SIZE];
+    int promptLength = strlen(PROMPT);
+    double start = now();
+
+    int running = sessionCount;
+    while (running > 0)
+    {
+        // Send every command that is due, and work out how long to wait for the next one
+        double current = now();
+        int timeout = -1;
+        for (int i = 0; i < sessionCount; i++)
+        {
+            Session *session = &sessions[i];
+            if (session->done || session->waiting || session->next == log.count)
+            {
+                continue;
+            }
+            double due = start;
+            if (recordedTiming)
+            {
+                due += log.commands[session->next].time - firstTime;
+            }
+            else if (rate > 0)
+            {
+                due += session->next / rate;
+            }
+            if (due > current)
+            {
+                int wait = (int)((due - current) * 1000) + 1;
+                if (timeout < 0 || wait < timeout)
+                {
+                    timeout = wait;
+                }
+                continue;
+            }
+
+            session->sentAt = (recordedTiming || rate > 0) ? due : current;
+            session->waiting = true;
+            if (!sendCommand(session, log.commands[session->next].text))
+            {
+                close(session->in);
+                session->in = -1;
+            }
+            session->next++;
+        }
+
+        struct pollfd fds[MAX_SESSIONS];
+        int owners[MAX_SESSIONS];
+        int polled = 0;
+        for (int i = 0; i < sessionCount; i++)
+        {
+            if (!sessions[i].done)
+            {
+                fds[polled].fd = sessions[i].out;
+                fds[polled].events = POLLIN;
+                owners[polled] = i;
+                polled++;
+            }
+        }
+        if (poll(fds, polled, timeout) < 0 && errno != EINTR)
+        {
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int p = 0; p < polled; p++)
+        {
+            if ((fds[p].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+            {
+                continue;
+            }
+            Session *session = &sessions[owners[p]];
+            ssize_t n = read(session->out, buffer, sizeof(buffer));
+            double received = now();
+            if (n <= 0)
+            {
+                // The process is gone, which also finishes a quit command
+                if (session->waiting && session->sentAt >= 0 && latencyCount < latencyCapacity)
+                {
+                    latencies[latencyCount++] = received - session->sentAt;
+                }
+                close(session->out);
+                if (session->in >= 0)
+                {
+                    close(session->in);
+                }
+                session->done = true;
+                running--;
+                continue;
+            }
+
+            // A prompt only counts at the start of a line, so one inside the echoed command
+            // or a park name does not end the command early
+            for (ssize_t c = 0; c < n; c++)
+            {
+                if ((session->matched > 0 || session->lineStart) && buffer[c] == PROMPT[session->matched])
+                {
+                    session->matched++;
+                }
+                else
+                {
+                    session->matched = 0;
+                }
+                session->lineStart = buffer[c] == '\n';
+                if (session->matched == promptLength)
+                {
+                    session->matched = 0;
+                    if (!session->waiting)
+                    {
+                        continue;
+                    }
+                    if (session->sentAt >= 0 && latencyCount < latencyCapacity)
+                    {
+                        latencies[latencyCount++] = received - session->sentAt;
+                    }
+                    session->waiting = false;
+                    if (session->next == log.count && session->in >= 0)
+                    {
+                        close(session->in);
+                        session->in = -1;
+                    }
+                }
+            }
+        }
+    }
+    double elapsed = now() - start;
+
+    int failures = 0;
+    for (int i = 0; i < sessionCount; i++)
+    {
+        int status;
+        waitpid(sessions[i].pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        {
+            failures++;
+        }
+    }
+
+    qsort(latencies, latencyCount, sizeof(double), compareLatencies);
+    printf("%-12s %d\n", "Sessions", sessionCount);
+    printf("%-12s %ld\n", "Commands", latencyCount);
+    printf("%-12s %.3f s\n", "Elapsed", elapsed);
+    printf("%-12s %.1f cmd/s\n", "Throughput", elapsed > 0 ? latencyCount / elapsed : 0.0);
+    if (latencyCount > 0)
+    {
+        printf("%-12s %.1f us\n", "Latency p50", percentile(latencies, latencyCount, 50) * 1e6);
+        printf("%-12s %.1f us\n", "Latency p90", percentile(latencies, latencyCount, 90) * 1e6);
+        printf("%-12s %.1f us\n", "Latency p99", percentile(latencies, latencyCount, 99) * 1e6);
+        printf("%-12s %.1f us\n", "Latency p999", percentile(latencies, latencyCount, 99.9) * 1e6);
+        printf("%-12s %.1f us\n", "Latency max", latencies[latencyCount - 1] * 1e6);
+    }
+    if (failures > 0)
+    {
+        printf("%-12s %d\n", "Failed", failures);
+    }
+
+    for (int i = 0; i < log.count; i++)
+    {
+        release(log.commands[i].text);
+    }
+    release(log.commands);
+    release(latencies);
+    return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
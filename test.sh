@@ -108,6 +108,28 @@ if [ -x parks ] ; then
  
     args=(parks-h.txt)
     runTest 20 1
+
+    # The journal tests run on copies, since opening a journal rewrites it.
+    # Journal 21 ends in half of a record, left by a crash in the middle of a write.
+    cp journal-21.bin journal.bin
+    cp journal-21.bin.snap journal.bin.snap
+    args=(--journal journal.bin parks-j.txt)
+    runTest 21 0
+
+    # Journal 22 is from an older epoch than its snapshot, left by a crash in the
+    # middle of compacting, so its changes are already in the snapshot.
+    cp journal-22.bin journal.bin
+    cp journal-22.bin.snap journal.bin.snap
+    args=(--journal journal.bin parks-j.txt)
+    runTest 22 0
+
+    # Snapshot and journal 23 name parks that are not in the park file.
+    cp journal-23.bin journal.bin
+    cp journal-23.bin.snap journal.bin.snap
+    args=(--journal journal.bin parks-j.txt)
+    runTest 23 0
+
+    rm -f journal.bin journal.bin.snap
  
 else
     echo "**** Your program couldn't be tested since it didn't compile successfully."